@@ -3,8 +3,24 @@
 
 #include "PanelMikr.h"
 
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <functional>
 #include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include "imgui.h"
 #include "hacks/hack_imgui.h" // ImGui::PushEnabled, ImGui::PopEnabled
@@ -12,26 +28,48 @@
 
 #include "sg/visitors/PrintNodes.h"
 
+// Where plugin_mikr.py is in the source tree, for running from a build
+#ifndef MIKR_PLUGIN_SCRIPT
+#define MIKR_PLUGIN_SCRIPT "plugin_mikr.py"
+#endif
+
 namespace ospray {
 namespace mikr_plugin {
 
 PanelMikr::PanelMikr(
   std::shared_ptr<StudioContext> context,
-  std::string optDefaultFilename
+  std::vector<std::string> optDefaultFilenames
 )
   : Panel("Mikr Panel", context)
 {
-  ui.coprocess.filename = optDefaultFilename;
   ui.coprocess.state.next = ui.coprocess.state.INITED;
   ui.coprocess.state.current = ui.coprocess.state.next;
+  ui.coprocess.cancelled = false;
+  ui.coprocess.started.task = nullptr;
   ui.coprocess.loaded.task = nullptr;
   ui.coprocess.loaded.completed = 0;
   ui.coprocess.transferred.task = nullptr;
   ui.coprocess.transferred.completed = 0;
   ui.coprocess.created.task = nullptr;
   ui.coprocess.created.completed = 0;
+  ui.coprocess.stopped.task = nullptr;
+  ui.daemon.enabled = false;
+  if (const char *runtime = std::getenv("XDG_RUNTIME_DIR")) {
+    ui.daemon.socket = std::string(runtime) + "/mikr_plugin.sock";
+  } else {
+    ui.daemon.socket = "/tmp/mikr_plugin-" + std::to_string(getuid()) + ".sock";
+  }
   ui.geometry.mode = ui.geometry.SAME_WORLD;
   ui.tfn.mode = ui.tfn.SAME_TRANSFER_FUNCTION;
+  ui.layout.mode = ui.layout.SIDE_BY_SIDE;
+  ui.difference.enabled = false;
+  ui.lod.enabled = true;
+  ui.lod.active = false;
+  ui.lod.factor = 4;
+  ui.lod.aggregate = ui.lod.MAXIMUM;
+  ui.roi.enabled = false;
+  ui.roi.minimum = vec3f(0.0f);
+  ui.roi.maximum = vec3f(0.0f);
   ui.timestep.index.current = 0;
   ui.timestep.index.previous = 0;
   ui.animation.mode = ui.animation.STOPPED;
@@ -39,12 +77,56 @@ PanelMikr::PanelMikr(
   ui.animation.time.current = clock::now();
   ui.animation.time.previous = ui.animation.time.current;
   ui.animation.time.waitingForFinishedFrame = false;
-  coprocess.pid = 0;
-  coprocess.stdin = nullptr;
-  coprocess.stdout = nullptr;
-  timesteps.count = 0;
-  timesteps.nbytes = 0;
-  timesteps.t.clear();
+  topologies.g.clear();
+  datasets.timesteps = 0;
+  datasets.nbytes = 0;
+  datasets.vertex.position.minimum = vec3f(0.0f);
+  datasets.vertex.position.maximum = vec3f(0.0f);
+  datasets.cell.data.minimum = 0.0f;
+  datasets.cell.data.maximum = 0.0f;
+  if (optDefaultFilenames.empty()) {
+    optDefaultFilenames.emplace_back();
+  }
+  datasets.d.resize(optDefaultFilenames.size());
+  for (size_t k=0; k<datasets.d.size(); ++k) {
+    initDataset(datasets.d[k]);
+    datasets.d[k].filename = optDefaultFilenames[k];
+  }
+}
+
+PanelMikr::~PanelMikr()
+{
+  // A load, transfer or create may still be running on its worker thread,
+  // reading the pipes and filling arena buffers: stop it and wait for it
+  // before tearing either down.
+  cancelCoProcess();
+  for (std::unique_ptr<Task> *task : {
+    &ui.coprocess.started.task,
+    &ui.coprocess.loaded.task,
+    &ui.coprocess.transferred.task,
+    &ui.coprocess.created.task,
+    &ui.coprocess.stopped.task,
+  }) {
+    if (*task) {
+      (*task)->wait();
+      task->reset();
+    }
+  }
+
+  stopCoProcess();
+  releaseTimesteps();
+}
+
+void PanelMikr::initDataset(Dataset &dataset) {
+  dataset.filename.clear();
+  dataset.coprocess.pid = 0;
+  dataset.coprocess.stdin = nullptr;
+  dataset.coprocess.stdout = nullptr;
+  dataset.difference.enabled = false;
+  dataset.difference.minimum = 0.0f;
+  dataset.difference.maximum = 0.0f;
+  dataset.timesteps.count = 0;
+  dataset.timesteps.t.clear();
 }
 
 void PanelMikr::buildUI(void *ImGuiCtx)
@@ -60,12 +142,30 @@ void PanelMikr::buildUI(void *ImGuiCtx)
   ui.coprocess.state.current = ui.coprocess.state.next;
 
   ImGui::PushEnabled(ui.coprocess.state.current == ui.coprocess.state.INITED); {
+    for (size_t k=0; k<datasets.d.size(); ++k) {
+      ImGui::PushID((int)k); {
+        std::string temp{datasets.d[k].filename};
+        temp.resize(1024, '\0');
+        ImGuiInputTextFlags flags{0};
+        if (ImGui::InputText("###datasets.d[k].filename", const_cast<char *>(temp.data()), 1024, flags)) {
+          datasets.d[k].filename = temp.c_str();
+        }
+        ImGui::PushEnabled(datasets.d.size() > 1); {
+          if (ImGui::SameLine(), ImGui::Button("-###datasets.d[k].remove")) {
+            datasets.d.erase(datasets.d.begin() + k);
+            --k;
+          }
+        } ImGui::PopEnabled(/* datasets.d.size() > 1 */);
+      } ImGui::PopID(/* k */);
+    }
+    if (ImGui::Button("Add Dataset###datasets.d.add")) {
+      datasets.d.emplace_back();
+      initDataset(datasets.d.back());
+    }
     {
-      std::string temp{ui.coprocess.filename};
-      temp.resize(1024, '\0');
-      ImGuiInputTextFlags flags{0};
-      if (ImGui::InputText("###ui.coprocess.filename", const_cast<char *>(temp.data()), 1024, flags)) {
-        ui.coprocess.filename = temp;
+      bool temp = ui.layout.mode == ui.layout.SIDE_BY_SIDE;
+      if (ImGui::Checkbox("Side by Side###ui.layout.mode", &temp)) {
+        ui.layout.mode = temp ? ui.layout.SIDE_BY_SIDE : ui.layout.OVERLAID;
       }
     }
     {
@@ -85,6 +185,15 @@ void PanelMikr::buildUI(void *ImGuiCtx)
         }
       }
     } ImGui::PopEnabled(/* ui.geometry.mode == ui.geometry.SAME_WORLD */);
+    ImGui::Checkbox("Use Loader Service###ui.daemon.enabled", &ui.daemon.enabled);
+    ImGui::PushEnabled(ui.daemon.enabled); {
+      std::string temp{ui.daemon.socket};
+      temp.resize(1024, '\0');
+      ImGuiInputTextFlags flags{0};
+      if (ImGui::InputText("Socket###ui.daemon.socket", const_cast<char *>(temp.data()), 1024, flags)) {
+        ui.daemon.socket = temp.c_str();
+      }
+    } ImGui::PopEnabled(/* ui.daemon.enabled */);
     if (ImGui::Button("Start Python Co-Process###ui.coprocess.started.task")) {
       ui.coprocess.state.next = ui.coprocess.state.STARTED_ACTIVE;
       std::fprintf(stderr, "Before startCoProcess task\n");
@@ -102,9 +211,18 @@ void PanelMikr::buildUI(void *ImGuiCtx)
   ImGui::PushEnabled(ui.coprocess.state.current == ui.coprocess.state.STARTED); {
     if (ImGui::Button("Load Data in Co-Process###ui.coprocess.loaded.task")) {
       ui.coprocess.state.next = ui.coprocess.state.LOADED_ACTIVE;
+      ui.coprocess.cancelled = false;
       ui.coprocess.loaded.task = std::make_unique<Task>([this]() {
-        loadInCoProcess();
-        ui.coprocess.state.next = ui.coprocess.state.LOADED;
+        if (loadInCoProcess()) {
+          ui.coprocess.state.next = ui.coprocess.state.LOADED;
+        } else {
+          // Either cancelled (the co-process was killed mid-parse) or the
+          // co-process died on its own: in both cases there is nothing to
+          // resume, so reap it and start over.
+          stopCoProcess();
+          releaseTimesteps();
+          ui.coprocess.state.next = ui.coprocess.state.INITED;
+        }
       });
     }
     // {
@@ -114,28 +232,97 @@ void PanelMikr::buildUI(void *ImGuiCtx)
   } ImGui::PopEnabled(/* ui.coprocess.state.current == ui.coprocess.state.STARTED */);
 
   ImGui::PushEnabled(ui.coprocess.state.current == ui.coprocess.state.LOADED); {
+    // The ROI cannot change once some timesteps have been cropped with it
+    ImGui::PushEnabled(ui.coprocess.transferred.completed == 0); {
+      {
+        bool temp = ui.roi.enabled;
+        if (ImGui::Checkbox("Crop to Region of Interest###ui.roi.enabled", &temp)) {
+          ui.roi.enabled = temp;
+        }
+      }
+      ImGui::PushEnabled(ui.roi.enabled); {
+        const vec3f &lo = datasets.vertex.position.minimum;
+        const vec3f &hi = datasets.vertex.position.maximum;
+        const char *labels[] = { "X###ui.roi.x", "Y###ui.roi.y", "Z###ui.roi.z" };
+        for (int k=0; k<3; ++k) {
+          float speed = (hi[k] - lo[k]) / 1000.0f;
+          float temp[2] = { ui.roi.minimum[k], ui.roi.maximum[k] };
+          if (ImGui::DragFloatRange2(labels[k], &temp[0], &temp[1], speed, lo[k], hi[k], "%.3f", "%.3f", ImGuiSliderFlags_AlwaysClamp)) {
+            ui.roi.minimum[k] = temp[0];
+            ui.roi.maximum[k] = temp[1];
+          }
+        }
+        if (ImGui::Button("Reset###ui.roi.reset")) {
+          ui.roi.minimum = lo;
+          ui.roi.maximum = hi;
+        }
+        if (ImGui::SameLine(), ImGui::Button("From Camera View###ui.roi.camera")) {
+          setRegionOfInterestFromCamera();
+        }
+      } ImGui::PopEnabled(/* ui.roi.enabled */);
+    } ImGui::PopEnabled(/* ui.coprocess.transferred.completed == 0 */);
     if (ImGui::Button("Transfer Data from Co-Process###ui.coprocess.transferred.task")) {
       ui.coprocess.state.next = ui.coprocess.state.TRANSFERRED_ACTIVE;
+      ui.coprocess.cancelled = false;
       ui.coprocess.transferred.task = std::make_unique<Task>([this]() {
-        transferFromCoProcess();
-        ui.coprocess.state.next = ui.coprocess.state.TRANSFERRED;
+        if (!transferFromCoProcess()) {
+          stopCoProcess();
+          releaseTimesteps();
+          ui.coprocess.state.next = ui.coprocess.state.INITED;
+        } else if (ui.coprocess.transferred.completed == datasets.timesteps * datasets.d.size()) {
+          ui.coprocess.state.next = ui.coprocess.state.TRANSFERRED;
+        } else {
+          // Cancelled between timesteps; pressing Transfer again resumes
+          ui.coprocess.state.next = ui.coprocess.state.LOADED;
+        }
       });
     }
     {
-      if (timesteps.count == 0) {
+      size_t total = datasets.timesteps * datasets.d.size();
+      if (total == 0) {
         ImGui::ProgressBar(0.0f, ImVec2(-FLT_MIN, 0), "Not Started");
       } else {
         size_t completed{ui.coprocess.transferred.completed};
         std::string temp(1024, '\0');
-        std::snprintf(const_cast<char *>(temp.data()), 64, "%zu/%zu (%'zuMB)", completed, timesteps.count, timesteps.nbytes / 1024ul / 1024ul);
-        ImGui::ProgressBar((float)completed / (float)timesteps.count, ImVec2(-FLT_MIN, 0), temp.c_str());
+        std::snprintf(const_cast<char *>(temp.data()), 64, "%zu/%zu (%'zuMB)", completed, total, datasets.nbytes / 1024ul / 1024ul);
+        ImGui::ProgressBar((float)completed / (float)total, ImVec2(-FLT_MIN, 0), temp.c_str());
       }
+      ImGui::Text("Arena: %'zuMB used / %'zuMB reserved", arena.used() / 1024ul / 1024ul, arena.reserved() / 1024ul / 1024ul);
     }
   } ImGui::PopEnabled(/* ui.coprocess.state.current == ui.coprocess.state.LOADED */);
 
   ImGui::PushEnabled(ui.coprocess.state.current == ui.coprocess.state.TRANSFERRED); {
+    ImGui::PushEnabled(datasets.d.size() > 1 && ui.coprocess.created.completed == 0); {
+      bool temp = ui.difference.enabled;
+      if (ImGui::Checkbox("Show Difference to First Dataset###ui.difference.enabled", &temp)) {
+        ui.difference.enabled = temp;
+      }
+    } ImGui::PopEnabled(/* datasets.d.size() > 1 && ui.coprocess.created.completed == 0 */);
+    ImGui::PushEnabled(ui.coprocess.created.completed == 0); {
+      {
+        bool temp = ui.lod.enabled;
+        if (ImGui::Checkbox("Coarse Volume while Scrubbing###ui.lod.enabled", &temp)) {
+          ui.lod.enabled = temp;
+        }
+      }
+      ImGui::PushEnabled(ui.lod.enabled); {
+        {
+          int temp = ui.lod.factor;
+          if (ImGui::SliderInt("###ui.lod.factor", &temp, 2, 16, "%d Cells per Coarse Cell Edge", ImGuiSliderFlags_AlwaysClamp)) {
+            ui.lod.factor = temp;
+          }
+        }
+        if (ImGui::RadioButton("Maximum###ui.lod.MAXIMUM", ui.lod.aggregate == ui.lod.MAXIMUM)) {
+          ui.lod.aggregate = ui.lod.MAXIMUM;
+        }
+        if (ImGui::SameLine(), ImGui::RadioButton("Mean###ui.lod.MEAN", ui.lod.aggregate == ui.lod.MEAN)) {
+          ui.lod.aggregate = ui.lod.MEAN;
+        }
+      } ImGui::PopEnabled(/* ui.lod.enabled */);
+    } ImGui::PopEnabled(/* ui.coprocess.created.completed == 0 */);
     if (ImGui::Button("Create Geometry###ui.coprocess.created.task")) {
       ui.coprocess.state.next = ui.coprocess.state.CREATED_ACTIVE;
+      ui.coprocess.cancelled = false;
       context->frame->pauseRendering = true;
       context->frame->cancelFrame();
       context->frame->waitOnFrame();
@@ -146,7 +333,12 @@ void PanelMikr::buildUI(void *ImGuiCtx)
     }
     if (ui.coprocess.state.current == ui.coprocess.state.CREATED_ACTIVE) {
       if (ui.coprocess.created.task->finished()) {
-        ui.coprocess.state.next = ui.coprocess.state.CREATED;
+        if (ui.coprocess.created.completed == datasets.timesteps * datasets.d.size()) {
+          ui.coprocess.state.next = ui.coprocess.state.CREATED;
+        } else {
+          // Cancelled between timesteps; pressing Create again resumes
+          ui.coprocess.state.next = ui.coprocess.state.TRANSFERRED;
+        }
 
         ui.coprocess.created.task->wait();
         ui.coprocess.created.task.reset();
@@ -155,13 +347,16 @@ void PanelMikr::buildUI(void *ImGuiCtx)
         context->refreshScene(true);
       }
     }
-    if (timesteps.count == 0) {
-      ImGui::ProgressBar(0.0f, ImVec2(-FLT_MIN, 0), "Not Started");
-    } else {
-      size_t completed{ui.coprocess.created.completed};
-      std::string temp(1024, '\0');
-      std::snprintf(const_cast<char *>(temp.data()), 64, "%zu/%zu", completed, timesteps.count);
-      ImGui::ProgressBar((float)completed / (float)timesteps.count, ImVec2(-FLT_MIN, 0), temp.c_str());
+    {
+      size_t total = datasets.timesteps * datasets.d.size();
+      if (total == 0) {
+        ImGui::ProgressBar(0.0f, ImVec2(-FLT_MIN, 0), "Not Started");
+      } else {
+        size_t completed{ui.coprocess.created.completed};
+        std::string temp(1024, '\0');
+        std::snprintf(const_cast<char *>(temp.data()), 64, "%zu/%zu", completed, total);
+        ImGui::ProgressBar((float)completed / (float)total, ImVec2(-FLT_MIN, 0), temp.c_str());
+      }
     }
   } ImGui::PopEnabled(/* ui.coprocess.state.current == ui.coprocess.state.TRANSFERRED */);
 
@@ -183,20 +378,35 @@ void PanelMikr::buildUI(void *ImGuiCtx)
         if (ImGui::SameLine(), ImGui::Button("<")) {
           --temp;
         }
-        if (ImGui::SameLine(), ImGui::SliderInt("", &temp, 0, timesteps.count - 1, "Timestep %d", ImGuiSliderFlags_AlwaysClamp)) {
+        if (ImGui::SameLine(), ImGui::SliderInt("", &temp, 0, datasets.timesteps - 1, "Timestep %d", ImGuiSliderFlags_AlwaysClamp)) {
           // no op
         }
+        bool isScrubbing = ImGui::IsItemActive();
         if (ImGui::SameLine(), ImGui::Button(">")) {
           ++temp;
         }
         if (ImGui::SameLine(), ImGui::Button(">>")) {
-          temp = timesteps.count - 1;
+          temp = datasets.timesteps - 1;
         }
 
         bool shouldAnimate = 
           ui.coprocess.state.current == ui.coprocess.state.CREATED &&
           ui.animation.mode == ui.animation.PLAYING;
 
+        // Swap in the coarse volumes while the timestep keeps changing and
+        // go back to full resolution once it settles.
+        bool shouldUseLod =
+          ui.coprocess.state.current == ui.coprocess.state.CREATED &&
+          ui.lod.enabled && (isScrubbing || shouldAnimate);
+
+        if (shouldUseLod != ui.lod.active) {
+          ui.lod.active = shouldUseLod;
+          for (size_t k=0; k<datasets.d.size(); ++k) {
+            setVisible(k, ui.timestep.index.current, true);
+          }
+          context->refreshScene(false);
+        }
+
         if (shouldAnimate) {
           ui.animation.time.current = clock::now();
           using namespace std::literals::chrono_literals;
@@ -215,15 +425,15 @@ void PanelMikr::buildUI(void *ImGuiCtx)
           }
         }
 
-        if (timesteps.count != 0 && temp < 0) {
-          temp += timesteps.count;
-          assert(timesteps.count == 0 || (0 <= temp && temp < timesteps.count));
+        if (datasets.timesteps != 0 && temp < 0) {
+          temp += datasets.timesteps;
+          assert(datasets.timesteps == 0 || (0 <= temp && temp < datasets.timesteps));
         }
-        if (timesteps.count != 0 && temp >= timesteps.count) {
-          temp -= timesteps.count;
-          assert(timesteps.count == 0 || (0 <= temp && temp < timesteps.count));
+        if (datasets.timesteps != 0 && temp >= datasets.timesteps) {
+          temp -= datasets.timesteps;
+          assert(datasets.timesteps == 0 || (0 <= temp && temp < datasets.timesteps));
         }
-        assert(timesteps.count == 0 || (0 <= temp && temp < timesteps.count));
+        assert(datasets.timesteps == 0 || (0 <= temp && temp < datasets.timesteps));
         ui.timestep.index.current = (size_t)temp;
       } ImGui::PopID(/* "ui.timestep.index.current" */);
     } ImGui::PopEnabled(/* ui.animation.mode == ui.animation.STOPPED */);
@@ -259,29 +469,61 @@ void PanelMikr::buildUI(void *ImGuiCtx)
     } ImGui::PopID(/* "ui.animation.fps" */);
 
     if (ui.timestep.index.current != ui.timestep.index.previous) {
-      if (ui.geometry.mode == ui.geometry.SEPARATE_WORLDS) {
-        context->frame->add(timesteps.t[ui.timestep.index.current].world.node, "world");
-      } else if (ui.geometry.mode == ui.geometry.SAME_WORLD) {
-        timesteps.t[ui.timestep.index.previous].world.tfn.xfm.vol.node->child("visible").setValue(false);
-        timesteps.t[ui.timestep.index.current].world.tfn.xfm.vol.node->child("visible").setValue(true);
-      } else {
-        assert(0);
-      }
+      showTimestep(ui.timestep.index.previous, ui.timestep.index.current);
 
       context->refreshScene(false);
       ui.timestep.index.previous = ui.timestep.index.current;
     }
   } ImGui::PopEnabled(/* ui.coprocess.state.current == ui.coprocess.state.CREATED */);
 
-  ImGui::PushEnabled(ui.coprocess.state.current == ui.coprocess.state.INITED); {
-    if (ImGui::Button("Stop Python Co-Process###ui.coprocess.state.STOPPED")) {
-      ui.coprocess.state.next = ui.coprocess.state.STOPPED_ACTIVE;
-      ui.coprocess.stopped.task = std::make_unique<Task>([this]() {
-        stopCoProcess();
-        ui.coprocess.state.next = ui.coprocess.state.STOPPED;
-      });
+  {
+    bool isActive =
+      ui.coprocess.state.current == ui.coprocess.state.LOADED_ACTIVE ||
+      ui.coprocess.state.current == ui.coprocess.state.TRANSFERRED_ACTIVE ||
+      ui.coprocess.state.current == ui.coprocess.state.CREATED_ACTIVE;
+
+    ImGui::PushEnabled(isActive && !ui.coprocess.cancelled); {
+      if (ImGui::Button("Cancel###ui.coprocess.cancelled")) {
+        cancelCoProcess();
+      }
+    } ImGui::PopEnabled(/* isActive && !ui.coprocess.cancelled */);
+  }
+
+  {
+    bool isIdle =
+      ui.coprocess.state.current == ui.coprocess.state.STARTED ||
+      ui.coprocess.state.current == ui.coprocess.state.LOADED ||
+      ui.coprocess.state.current == ui.coprocess.state.TRANSFERRED ||
+      ui.coprocess.state.current == ui.coprocess.state.CREATED;
+
+    ImGui::PushEnabled(isIdle); {
+      if (ImGui::SameLine(), ImGui::Button("Stop Python Co-Process###ui.coprocess.state.STOPPED")) {
+        ui.coprocess.state.next = ui.coprocess.state.STOPPED_ACTIVE;
+        ui.animation.mode = ui.animation.STOPPED;
+        context->frame->pauseRendering = true;
+        context->frame->cancelFrame();
+        context->frame->waitOnFrame();
+
+        ui.coprocess.stopped.task = std::make_unique<Task>([this]() {
+          stopCoProcess();
+          releaseGeometry();
+          releaseTimesteps();
+          ui.coprocess.state.next = ui.coprocess.state.STOPPED;
+        });
+      }
+    } ImGui::PopEnabled(/* isIdle */);
+
+    if (ui.coprocess.state.current == ui.coprocess.state.STOPPED) {
+      // Back to INITED so that another dataset can be loaded in this session
+      ui.coprocess.state.next = ui.coprocess.state.INITED;
+
+      ui.coprocess.stopped.task->wait();
+      ui.coprocess.stopped.task.reset();
+
+      context->frame->pauseRendering = false;
+      context->refreshScene(true);
     }
-  } ImGui::PopEnabled(/* ui.coprocess.state.current == ui.coprocess.state.INITED */);
+  }
 
   if (ImGui::Button("Close")) {
     setShown(false);
@@ -291,130 +533,545 @@ void PanelMikr::buildUI(void *ImGuiCtx)
   ImGui::End();
 }
 
-void PanelMikr::startCoProcess() {
-  int pid;
-  int fds_stdin[2];
-  int fds_stdout[2];
+void PanelMikr::setRegionOfInterestFromCamera() {
+  // The ROI is the bounding box of the part of the view frustum that
+  // lies within the full mesh: the eye plus the four far corners, where
+  // "far" is the most distant mesh corner along the view direction.
+  auto &camera = context->frame->child("camera");
+  if (!camera.hasChild("fovy")) {
+    std::fprintf(stderr, "ROI from camera requires a perspective camera\n");
+    return;
+  }
 
+  vec3f position = camera["position"].valueAs<vec3f>();
+  vec3f direction = normalize(camera["direction"].valueAs<vec3f>());
+  vec3f up = normalize(camera["up"].valueAs<vec3f>());
+  vec3f right = normalize(cross(direction, up));
+  up = cross(right, direction);
+  float fovy = camera["fovy"].valueAs<float>();
+  float aspect = camera["aspect"].valueAs<float>();
+
+  const vec3f &lo = datasets.vertex.position.minimum;
+  const vec3f &hi = datasets.vertex.position.maximum;
+  float depth = 0.0f;
+  for (int k=0; k<8; ++k) {
+    vec3f corner((k & 1) ? hi.x : lo.x, (k & 2) ? hi.y : lo.y, (k & 4) ? hi.z : lo.z);
+    depth = std::max(depth, dot(corner - position, direction));
+  }
+  if (depth <= 0.0f) {
+    std::fprintf(stderr, "ROI from camera: mesh is behind the camera\n");
+    return;
+  }
+
+  float halfHeight = depth * std::tan(0.5f * fovy * (float)M_PI / 180.0f);
+  float halfWidth = halfHeight * aspect;
+
+  vec3f minimum = position;
+  vec3f maximum = position;
+  for (int k=0; k<4; ++k) {
+    vec3f corner = position + depth * direction
+      + ((k & 1) ? halfWidth : -halfWidth) * right
+      + ((k & 2) ? halfHeight : -halfHeight) * up;
+    minimum = min(minimum, corner);
+    maximum = max(maximum, corner);
+  }
+
+  ui.roi.minimum = max(lo, min(hi, minimum));
+  ui.roi.maximum = max(lo, min(hi, maximum));
+}
+
+void PanelMikr::startCoProcess() {
   std::fprintf(stderr, "Start\n");
 
-  pipe(fds_stdin);
-  pipe(fds_stdout);
+  // Writing to a co-process that was killed or crashed must surface as a
+  // short write rather than terminate Studio.
+  signal(SIGPIPE, SIG_IGN);
+
+  if (ui.daemon.enabled) {
+    // One connection per dataset to the long-lived loader service, which
+    // keeps recently parsed datasets in memory between sessions. From here
+    // on it speaks the same protocol as a forked co-process.
+    for (size_t k=0; k<datasets.d.size(); ++k) {
+      // -1: nothing listening yet, -2: listening but not ours
+      int fd = connectToDaemon();
+      if (fd == -1) {
+        using namespace std::literals::chrono_literals;
+        spawnDaemon();
+        time_point deadline = clock::now() + 10s;
+        while ((fd = connectToDaemon()) == -1 && clock::now() < deadline) {
+          std::this_thread::sleep_for(100ms);
+        }
+      }
+      if (fd < 0) {
+        std::fprintf(stderr, "Could not connect to loader service at %s\n", ui.daemon.socket.c_str());
+        continue;
+      }
+
+      datasets.d[k].coprocess.pid = 0;
+      // A plain dup() would drop close-on-exec and leak the connection into
+      // every later fork/exec from Studio
+      datasets.d[k].coprocess.stdin = fdopen(fcntl(fd, F_DUPFD_CLOEXEC, 0), "w");
+      datasets.d[k].coprocess.stdout = fdopen(fd, "r");
+
+      // Handshake: which dataset this connection is for
+      std::string path = resolveDatasetPath(datasets.d[k].filename);
+      std::fprintf(stderr, "Dataset %zu: %s\n", k, path.c_str());
+      ssize_t temp = path.size();
+      writeToCoProcess(k, &temp, sizeof(temp));
+      writeToCoProcess(k, path.data(), temp);
+    }
+    return;
+  }
+
+  std::string script = scriptPath();
+
+  for (size_t k=0; k<datasets.d.size(); ++k) {
+    int pid;
+    int fds_stdin[2];
+    int fds_stdout[2];
+
+    pipe(fds_stdin);
+    pipe(fds_stdout);
+    if ((pid = fork()) == 0) { // child
+      close(0);
+      dup2(fds_stdin[0], 0);
+      close(fds_stdin[0]);
+      close(fds_stdin[1]);
+
+      close(1);
+      dup2(fds_stdout[1], 1);
+      close(fds_stdout[0]);
+      close(fds_stdout[1]);
+
+      // Don't keep the earlier co-processes' pipes open, or they would not
+      // see end-of-file when Studio goes away.
+      for (size_t j=0; j<k; ++j) {
+        close(fileno(datasets.d[j].coprocess.stdin));
+        close(fileno(datasets.d[j].coprocess.stdout));
+      }
+
+      const char *argv[16];
+      size_t i = 0;
+      argv[i++] = "python3";
+      argv[i++] = script.c_str();
+      if (!datasets.d[k].filename.empty()) {
+        argv[i++] = "--data";
+        argv[i++] = datasets.d[k].filename.c_str();
+      }
+      argv[i++] = NULL;
+
+
+      execvp(argv[0], const_cast<char *const *>(argv));
+      perror("execlp");
+      exit(0);
+
+    } else { // parent
+      datasets.d[k].coprocess.pid = pid;
+      close(fds_stdin[0]);
+      datasets.d[k].coprocess.stdin = fdopen(fds_stdin[1], "w");
+      close(fds_stdout[1]);
+      datasets.d[k].coprocess.stdout = fdopen(fds_stdout[0], "r");
+      //wait(coprocess_pid);
+    }
+  }
+}
+
+std::string PanelMikr::scriptPath() {
+  // An explicit override first, then the copy installed next to this
+  // plugin's library, then the source tree it was built from
+  if (const char *path = std::getenv("MIKR_PLUGIN_SCRIPT")) {
+    return path;
+  }
+
+  static const char anchor = 0; // any address inside this library
+  Dl_info info;
+  if (dladdr(&anchor, &info) && info.dli_fname) {
+    std::string path = info.dli_fname;
+    size_t slash = path.find_last_of('/');
+    path = (slash == std::string::npos ? std::string(".") : path.substr(0, slash)) + "/plugin_mikr.py";
+    if (access(path.c_str(), R_OK) == 0) {
+      return path;
+    }
+  }
+
+  return MIKR_PLUGIN_SCRIPT;
+}
+
+std::string PanelMikr::resolveDatasetPath(std::string filename) {
+  // The loader service runs in whatever directory the first Studio was
+  // started from, so it is only ever sent absolute, canonical paths.
+  if (filename.empty()) {
+    // Same default dataset as plugin_mikr.py
+    filename = "data/bridge_15mm/bridge_15mm_subset.zip/bridge_15mm";
+  }
+  if (filename[0] != '/') {
+    char cwd[PATH_MAX];
+    if (getcwd(cwd, sizeof(cwd))) {
+      filename = std::string(cwd) + "/" + filename;
+    }
+  }
+
+  // realpath() cannot see into a .zip, so resolve the longest prefix that
+  // exists on disk and keep the members below it as they are
+  std::string head = filename;
+  std::string rest;
+  for (;;) {
+    char resolved[PATH_MAX];
+    if (realpath(head.c_str(), resolved)) {
+      return std::string(resolved) + rest;
+    }
+    size_t slash = head.find_last_of('/');
+    if (slash == std::string::npos || slash == 0) {
+      return filename;
+    }
+    rest = head.substr(slash) + rest;
+    head.resize(slash);
+  }
+}
+
+int PanelMikr::connectToDaemon() {
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (ui.daemon.socket.size() >= sizeof(address.sun_path)) {
+    std::fprintf(stderr, "Socket path too long: %s\n", ui.daemon.socket.c_str());
+    return -1;
+  }
+  std::strcpy(address.sun_path, ui.daemon.socket.c_str());
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    perror("socket");
+    return -1;
+  }
+  if (connect(fd, (sockaddr *)&address, sizeof(address)) < 0) {
+    close(fd);
+    return -1;
+  }
+
+  // Anyone can create a socket at a guessable path under /tmp first, and
+  // the service is sent dataset paths and trusted for array sizes and
+  // indices: only talk to one run by this user.
+  uid_t uid = (uid_t)-1;
+#ifdef SO_PEERCRED
+  ucred credentials;
+  socklen_t length = sizeof(credentials);
+  if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length) == 0) {
+    uid = credentials.uid;
+  }
+#else
+  gid_t gid;
+  getpeereid(fd, &uid, &gid);
+#endif
+  if (uid != getuid()) {
+    std::fprintf(stderr, "Loader service at %s is not owned by this user, refusing it\n", ui.daemon.socket.c_str());
+    close(fd);
+    return -2;
+  }
+
+  return fd;
+}
+
+void PanelMikr::spawnDaemon() {
+  std::fprintf(stderr, "Spawning loader service at %s\n", ui.daemon.socket.c_str());
+
+  // The service outlives this Studio and the terminal it was started
+  // from, so it logs next to its socket instead.
+  std::string log = ui.daemon.socket + ".log";
+  std::string script = scriptPath();
+
+  // Double fork so the service is reparented away from Studio and outlives
+  // it; the intermediate child is reaped right away.
+  int pid;
   if ((pid = fork()) == 0) { // child
-    close(0);
-    dup2(fds_stdin[0], 0);
-    close(fds_stdin[0]);
-    close(fds_stdin[1]);
+    setsid();
+    if (fork() != 0) {
+      _exit(0);
+    }
 
-    close(1);
-    dup2(fds_stdout[1], 1);
-    close(fds_stdout[0]);
-    close(fds_stdout[1]);
+    int null = open("/dev/null", O_RDWR);
+    dup2(null, 0);
+    dup2(null, 1);
+    int err = open(log.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0600);
+    dup2(err < 0 ? null : err, 2);
+
+    // Nothing else Studio has open (co-process pipes, sockets, files)
+    // belongs in the service
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 34))
+    close_range(3, ~0U, 0);
+#else
+    for (int fd=3, n=(int)sysconf(_SC_OPEN_MAX); fd<n; ++fd) {
+      close(fd);
+    }
+#endif
 
     const char *argv[16];
     size_t i = 0;
     argv[i++] = "python3";
-    argv[i++] = "/home/thobson/src/ospray_studio_mikr/studio/plugins/mikr_plugin/plugin_mikr.py";
-    if (!ui.coprocess.filename.empty()) {
-      argv[i++] = "--data";
-      argv[i++] = ui.coprocess.filename.c_str();
-    }
+    argv[i++] = script.c_str();
+    argv[i++] = "--serve";
+    argv[i++] = ui.daemon.socket.c_str();
     argv[i++] = NULL;
 
-
     execvp(argv[0], const_cast<char *const *>(argv));
-    perror("execlp");
-    exit(0);
+    perror("execvp");
+    _exit(0);
 
-  } else { // parent
-    coprocess.pid = pid;
-    close(fds_stdin[0]);
-    coprocess.stdin = fdopen(fds_stdin[1], "w");
-    close(fds_stdout[1]);
-    coprocess.stdout = fdopen(fds_stdout[0], "r");
-    //wait(coprocess_pid);
+  } else if (pid > 0) { // parent
+    int status;
+    waitpid(pid, &status, 0);
   }
 }
 
-void PanelMikr::loadInCoProcess() {
+bool PanelMikr::readFromCoProcess(size_t k, void *data, size_t nbytes) {
+  if (!datasets.d[k].coprocess.stdout) return false;
+  size_t nread = fread(data, 1, nbytes, datasets.d[k].coprocess.stdout);
+  datasets.nbytes += nread;
+  return nread == nbytes;
+}
+
+bool PanelMikr::writeToCoProcess(size_t k, const void *data, size_t nbytes) {
+  if (!datasets.d[k].coprocess.stdin) return false;
+  size_t nwritten = fwrite(data, 1, nbytes, datasets.d[k].coprocess.stdin);
+  datasets.nbytes += nwritten;
+  return nwritten == nbytes;
+}
+
+bool PanelMikr::loadInCoProcess() {
   ssize_t temp;
   size_t i;
 
   std::fprintf(stderr, "Load\n");
 
-  temp = 0;
-  fwrite(&temp, sizeof(temp), 1, coprocess.stdin);
-  fflush(coprocess.stdin);
-
-  timesteps.nbytes += fread(&temp, 1, sizeof(temp), coprocess.stdout);
-  assert(temp >= 0);
-  timesteps.count = temp;
-  timesteps.t.resize(temp);
-  for (i=0; i<timesteps.count; ++i) {
-    ui.coprocess.loaded.completed = i;
-    timesteps.nbytes += fread(&temp, sizeof(temp), 1, coprocess.stdout);
+  // Let every co-process parse its dataset at the same time
+  for (size_t k=0; k<datasets.d.size(); ++k) {
+    temp = 0;
+    if (!writeToCoProcess(k, &temp, sizeof(temp))) return false;
+    fflush(datasets.d[k].coprocess.stdin);
+  }
+
+  for (size_t k=0; k<datasets.d.size(); ++k) {
+    auto &timesteps = datasets.d[k].timesteps;
+
+    if (!readFromCoProcess(k, &temp, sizeof(temp))) return false;
     assert(temp >= 0);
-    timesteps.t[i].name.resize(temp, '\0');
-    timesteps.nbytes += fread(const_cast<char *>(timesteps.t[i].name.data()), 1, temp, coprocess.stdout);
+    timesteps.count = temp;
+    timesteps.t.resize(temp);
+    for (i=0; i<timesteps.count; ++i) {
+      ui.coprocess.loaded.completed = i;
+      if (!readFromCoProcess(k, &temp, sizeof(temp))) return false;
+      assert(temp >= 0);
+      timesteps.t[i].name.resize(temp, '\0');
+      if (!readFromCoProcess(k, const_cast<char *>(timesteps.t[i].name.data()), temp)) return false;
+      timesteps.t[i].index = i;
+      timesteps.t[i].lod.cell.data.count = 0;
+      timesteps.t[i].lod.cell.data.data = nullptr;
+      timesteps.t[i].difference.data = nullptr;
+      timesteps.t[i].difference.lod = nullptr;
+    }
+
+    if (!readFromCoProcess(k, &timesteps.vertex.position.minimum, sizeof(vec3f))) return false;
+    if (!readFromCoProcess(k, &timesteps.vertex.position.maximum, sizeof(vec3f))) return false;
+  }
+
+  datasets.vertex.position.minimum = datasets.d[0].timesteps.vertex.position.minimum;
+  datasets.vertex.position.maximum = datasets.d[0].timesteps.vertex.position.maximum;
+  for (size_t k=1; k<datasets.d.size(); ++k) {
+    datasets.vertex.position.minimum = min(datasets.vertex.position.minimum, datasets.d[k].timesteps.vertex.position.minimum);
+    datasets.vertex.position.maximum = max(datasets.vertex.position.maximum, datasets.d[k].timesteps.vertex.position.maximum);
+  }
+
+  // The slider steps through all datasets together, so only the timesteps
+  // every dataset has (by name, in the first dataset's order) are kept.
+  // Each keeps its index in its own co-process for the transfer.
+  std::vector<std::unordered_map<std::string, size_t>> lookup(datasets.d.size());
+  for (size_t k=0; k<datasets.d.size(); ++k) {
+    for (i=0; i<datasets.d[k].timesteps.count; ++i) {
+      lookup[k][datasets.d[k].timesteps.t[i].name] = i;
+    }
+  }
+  std::vector<std::string> common;
+  for (const auto &t : datasets.d[0].timesteps.t) {
+    bool found = true;
+    for (size_t k=1; k<datasets.d.size(); ++k) {
+      found = found && lookup[k].count(t.name) != 0;
+    }
+    if (found) {
+      common.push_back(t.name);
+    }
+  }
+  if (common.empty()) {
+    std::fprintf(stderr, "Datasets have no timesteps in common\n");
+    return false;
   }
-  ui.coprocess.loaded.completed = timesteps.count;
+
+  datasets.timesteps = common.size();
+  for (size_t k=0; k<datasets.d.size(); ++k) {
+    auto &timesteps = datasets.d[k].timesteps;
+    if (timesteps.count != datasets.timesteps) {
+      std::fprintf(stderr, "Dataset %zu: using %zu of %zu timesteps\n", k, datasets.timesteps, timesteps.count);
+    }
+    decltype(timesteps.t) t(datasets.timesteps);
+    for (i=0; i<datasets.timesteps; ++i) {
+      t[i] = std::move(timesteps.t[lookup[k].at(common[i])]);
+    }
+    timesteps.t = std::move(t);
+    timesteps.count = datasets.timesteps;
+  }
+
+  ui.roi.minimum = datasets.vertex.position.minimum;
+  ui.roi.maximum = datasets.vertex.position.maximum;
+
+  ui.coprocess.loaded.completed = datasets.timesteps;
+  return true;
 }
 
-void PanelMikr::transferFromCoProcess() {
+bool PanelMikr::transferFromCoProcess() {
   ssize_t temp;
-  size_t nread;
 
   std::fprintf(stderr, "Transfer\n");
 
-  for (size_t i=0; i<timesteps.count; ++i) {
-    ui.coprocess.transferred.completed = i;
-    temp = i;
-    timesteps.nbytes += fwrite(&temp, 1, sizeof(temp), coprocess.stdin);
-    fflush(coprocess.stdin);
+  // Timesteps are transferred one dataset after the other, and resume
+  // after the last fully transferred one (0 on the first run).
+  size_t total = datasets.timesteps * datasets.d.size();
+  size_t first = ui.coprocess.transferred.completed;
+  for (size_t n=first; n<total; ++n) {
+    ui.coprocess.transferred.completed = n;
+    if (ui.coprocess.cancelled) {
+      std::fprintf(stderr, "Transfer cancelled at timestep %zu\n", n);
+      return true;
+    }
 
-    timesteps.nbytes += fread(&temp, 1, sizeof(temp), coprocess.stdout);
+    size_t k = n / datasets.timesteps;
+    size_t i = n % datasets.timesteps;
+    auto &timesteps = datasets.d[k].timesteps;
+
+    temp = timesteps.t[i].index;
+    if (!writeToCoProcess(k, &temp, sizeof(temp))) return false;
+    temp = ui.roi.enabled ? 1 : 0;
+    if (!writeToCoProcess(k, &temp, sizeof(temp))) return false;
+    if (!writeToCoProcess(k, &ui.roi.minimum, sizeof(vec3f))) return false;
+    if (!writeToCoProcess(k, &ui.roi.maximum, sizeof(vec3f))) return false;
+    fflush(datasets.d[k].coprocess.stdin);
+
+    size_t vertexCount;
+    size_t cellCount;
+    char digest[16];
+    if (!readFromCoProcess(k, &temp, sizeof(temp))) return false;
     assert(temp >= 0);
-    timesteps.t[i].vertex.position.count = temp;
-    
-    timesteps.nbytes += fread(&temp, 1, sizeof(temp), coprocess.stdout);
+    vertexCount = temp;
+    if (!readFromCoProcess(k, &temp, sizeof(temp))) return false;
     assert(temp >= 0);
-    timesteps.t[i].index.count = 8 * temp;
-    timesteps.t[i].cell.index.count = temp;
-    timesteps.t[i].cell.type.count = temp;
-    timesteps.t[i].cell.data.count = temp;
+    cellCount = temp;
+    if (!readFromCoProcess(k, digest, sizeof(digest))) return false;
+
+    if (cellCount == 0 && ui.roi.enabled) {
+      std::fprintf(stderr, "Dataset %zu timestep %s: no cells in the region of interest, not transferring\n", k, timesteps.t[i].name.c_str());
+
+      // Keep the co-process in step: decline the mesh and drain the (empty)
+      // cell data, then stop here so that nothing empty reaches Create
+      temp = 0;
+      if (!writeToCoProcess(k, &temp, sizeof(temp))) return false;
+      fflush(datasets.d[k].coprocess.stdin);
+      if (!readFromCoProcess(k, &temp, sizeof(temp))) return false;
+      if (temp != 0) return false;
+      return true;
+    }
 
-    timesteps.nbytes += fread(&temp, 1, sizeof(temp), coprocess.stdout);
-    assert(temp >= 0);
-    timesteps.t[i].vertex.position.data = (vec3f *)std::malloc(temp);
-    timesteps.nbytes += fread(timesteps.t[i].vertex.position.data, 1, temp, coprocess.stdout);
-    std::fprintf(stderr, "Read vertex.position\n");
+    timesteps.t[i].topology = nullptr;
+    for (auto &g : topologies.g) {
+      if (std::memcmp(g->digest, digest, sizeof(digest)) == 0 &&
+          g->vertex.position.count == vertexCount &&
+          g->cell.index.count == cellCount) {
+        timesteps.t[i].topology = g.get();
+        break;
+      }
+    }
 
-    fread(&temp, sizeof(temp), 1, coprocess.stdout);
-    assert(temp >= 0);
-    timesteps.t[i].index.data = (uint32_t *)std::malloc(temp);
-    timesteps.nbytes += fread(timesteps.t[i].index.data, 1, temp, coprocess.stdout);
-    std::fprintf(stderr, "Read index\n");
+    if (n == first) {
+      // Only the cell data is stored per timestep; topologies are shared,
+      // but the first one comes out of the same slab ahead of it
+      size_t nbytes = TimestepArena::round(cellCount * sizeof(float)) * (total - first);
+      if (timesteps.t[i].topology == nullptr) {
+        nbytes += TimestepArena::round(vertexCount * sizeof(vec3f));
+        nbytes += TimestepArena::round(8 * cellCount * sizeof(uint32_t));
+        nbytes += TimestepArena::round(cellCount * sizeof(uint32_t));
+        nbytes += TimestepArena::round(cellCount * sizeof(uint8_t));
+      }
+      arena.reserve(nbytes);
+    }
 
-    timesteps.nbytes += fread(&temp, sizeof(temp), 1, coprocess.stdout);
-    assert(temp >= 0);
-    timesteps.t[i].cell.index.data = (uint32_t *)std::malloc(temp);
-    timesteps.nbytes += fread(timesteps.t[i].cell.index.data, 1, temp, coprocess.stdout);
-    std::fprintf(stderr, "Read cell.index\n");
+    // Ask for the mesh arrays only when we do not have them yet
+    temp = timesteps.t[i].topology == nullptr ? 1 : 0;
+    if (!writeToCoProcess(k, &temp, sizeof(temp))) return false;
+    fflush(datasets.d[k].coprocess.stdin);
+
+    if (timesteps.t[i].topology == nullptr) {
+      topologies.g.emplace_back(new decltype(topologies)::_G());
+      auto &topology = *topologies.g.back();
+      std::memcpy(topology.digest, digest, sizeof(digest));
+      topology.vertex.position.count = vertexCount;
+      topology.index.count = 8 * cellCount;
+      topology.cell.index.count = cellCount;
+      topology.cell.type.count = cellCount;
+
+      if (!readFromCoProcess(k, &temp, sizeof(temp))) return false;
+      assert(temp == (ssize_t)(topology.vertex.position.count * sizeof(vec3f)));
+      topology.vertex.position.data = (vec3f *)arena.allocate(temp);
+      if (!readFromCoProcess(k, topology.vertex.position.data, temp)) return false;
+      std::fprintf(stderr, "Read vertex.position\n");
+
+      // Cropped extent of this mesh: spaces the datasets apart side by side
+      // and sets the grid the coarse volume bins cells into
+      if (topology.vertex.position.count != 0) {
+        topology.vertex.position.minimum = topology.vertex.position.data[0];
+        topology.vertex.position.maximum = topology.vertex.position.data[0];
+      } else {
+        topology.vertex.position.minimum = vec3f(0.0f);
+        topology.vertex.position.maximum = vec3f(0.0f);
+      }
+      for (size_t j=0; j<topology.vertex.position.count; ++j) {
+        topology.vertex.position.minimum = min(topology.vertex.position.minimum, topology.vertex.position.data[j]);
+        topology.vertex.position.maximum = max(topology.vertex.position.maximum, topology.vertex.position.data[j]);
+      }
 
-    timesteps.nbytes += fread(&temp, sizeof(temp), 1, coprocess.stdout);
-    assert(temp >= 0);
-    timesteps.t[i].cell.type.data = (uint8_t *)std::malloc(temp);
-    timesteps.nbytes += fread(timesteps.t[i].cell.type.data, 1, temp, coprocess.stdout);
-    std::fprintf(stderr, "Read cell.type\n");
+      if (!readFromCoProcess(k, &temp, sizeof(temp))) return false;
+      assert(temp == (ssize_t)(topology.index.count * sizeof(uint32_t)));
+      topology.index.data = (uint32_t *)arena.allocate(temp);
+      if (!readFromCoProcess(k, topology.index.data, temp)) return false;
+      std::fprintf(stderr, "Read index\n");
+
+      if (!readFromCoProcess(k, &temp, sizeof(temp))) return false;
+      assert(temp == (ssize_t)(topology.cell.index.count * sizeof(uint32_t)));
+      topology.cell.index.data = (uint32_t *)arena.allocate(temp);
+      if (!readFromCoProcess(k, topology.cell.index.data, temp)) return false;
+      std::fprintf(stderr, "Read cell.index\n");
+
+      if (!readFromCoProcess(k, &temp, sizeof(temp))) return false;
+      assert(temp == (ssize_t)(topology.cell.type.count * sizeof(uint8_t)));
+      topology.cell.type.data = (uint8_t *)arena.allocate(temp);
+      if (!readFromCoProcess(k, topology.cell.type.data, temp)) return false;
+      std::fprintf(stderr, "Read cell.type\n");
+
+      timesteps.t[i].topology = &topology;
+    } else {
+      std::fprintf(stderr, "Reusing topology\n");
+    }
 
-    timesteps.nbytes += fread(&temp, sizeof(temp), 1, coprocess.stdout);
-    assert(temp >= 0);
-    timesteps.t[i].cell.data.data = (float *)std::malloc(temp);
-    timesteps.nbytes += fread(timesteps.t[i].cell.data.data, 1, temp, coprocess.stdout);
+    timesteps.t[i].cell.data.count = cellCount;
+    if (!readFromCoProcess(k, &temp, sizeof(temp))) return false;
+    assert(temp == (ssize_t)(timesteps.t[i].cell.data.count * sizeof(float)));
+    timesteps.t[i].cell.data.data = (float *)arena.allocate(temp);
+    if (!readFromCoProcess(k, timesteps.t[i].cell.data.data, temp)) return false;
     std::fprintf(stderr, "Read cell.data\n");
 
-    timesteps.t[i].cell.data.minimum = timesteps.t[i].cell.data.data[0];
-    timesteps.t[i].cell.data.maximum = timesteps.t[i].cell.data.data[0];
+    if (timesteps.t[i].cell.data.count != 0) {
+      timesteps.t[i].cell.data.minimum = timesteps.t[i].cell.data.data[0];
+      timesteps.t[i].cell.data.maximum = timesteps.t[i].cell.data.data[0];
+    } else {
+      timesteps.t[i].cell.data.minimum = 0.0f;
+      timesteps.t[i].cell.data.maximum = 0.0f;
+    }
     for (size_t j=0; j<timesteps.t[i].cell.data.count; ++j) {
       if (timesteps.t[i].cell.data.data[j] < timesteps.t[i].cell.data.minimum) {
         timesteps.t[i].cell.data.minimum = timesteps.t[i].cell.data.data[j];
@@ -427,31 +1084,140 @@ void PanelMikr::transferFromCoProcess() {
     timesteps.t[i].cell.data.maximum += 1.0f;
   }
 
-  timesteps.cell.data.minimum = timesteps.t[0].cell.data.minimum;
-  timesteps.cell.data.maximum = timesteps.t[0].cell.data.maximum;
-  for (size_t i=1; i<timesteps.count; ++i) {
-    if (timesteps.t[i].cell.data.minimum < timesteps.cell.data.minimum) {
-      timesteps.cell.data.minimum = timesteps.t[i].cell.data.minimum;
-    }
-    if (timesteps.t[i].cell.data.maximum > timesteps.cell.data.maximum) {
-      timesteps.cell.data.maximum = timesteps.t[i].cell.data.maximum;
+  if (total == 0) {
+    return true;
+  }
+
+  // One value range across all datasets, so that they compare on one scale
+  datasets.cell.data.minimum = datasets.d[0].timesteps.t[0].cell.data.minimum;
+  datasets.cell.data.maximum = datasets.d[0].timesteps.t[0].cell.data.maximum;
+  for (size_t k=0; k<datasets.d.size(); ++k) {
+    auto &timesteps = datasets.d[k].timesteps;
+    for (size_t i=0; i<timesteps.count; ++i) {
+      if (timesteps.t[i].cell.data.minimum < datasets.cell.data.minimum) {
+        datasets.cell.data.minimum = timesteps.t[i].cell.data.minimum;
+      }
+      if (timesteps.t[i].cell.data.maximum > datasets.cell.data.maximum) {
+        datasets.cell.data.maximum = timesteps.t[i].cell.data.maximum;
+      }
     }
   }
 
-  ui.coprocess.transferred.completed = timesteps.count;
+  ui.coprocess.transferred.completed = total;
+  return true;
 }
 
 #define SG_PREFIX(x) ("mikr_" x)
 void PanelMikr::createGeometry() {
   std::fprintf(stderr, "Create\n");
 
-  for (size_t i=0; i<timesteps.count; ++i) {
-    ui.coprocess.created.completed = i;
+  size_t total = datasets.timesteps * datasets.d.size();
+
+  // Side by side, datasets are placed one mesh width (plus a gap) apart
+  vec3f spacing(0.0f);
+  if (ui.layout.mode == ui.layout.SIDE_BY_SIDE && !topologies.g.empty()) {
+    vec3f minimum = topologies.g[0]->vertex.position.minimum;
+    vec3f maximum = topologies.g[0]->vertex.position.maximum;
+    for (auto &g : topologies.g) {
+      minimum = min(minimum, g->vertex.position.minimum);
+      maximum = max(maximum, g->vertex.position.maximum);
+    }
+    spacing.x = 1.1f * (maximum.x - minimum.x);
+  }
+
+  // Coarse volumes are only built when asked for. Topologies and
+  // timesteps that already have one (from a cancelled run) keep it.
+  if (ui.lod.enabled && ui.coprocess.created.completed == 0) {
+    for (auto &g : topologies.g) {
+      if (g->lod.map == nullptr) {
+        buildLevelOfDetail(*g);
+      }
+    }
+    for (size_t k=0; k<datasets.d.size(); ++k) {
+      for (auto &t : datasets.d[k].timesteps.t) {
+        if (t.lod.cell.data.data == nullptr) {
+          t.lod.cell.data.count = t.topology->lod.count;
+          t.lod.cell.data.data = (float *)arena.allocate(t.lod.cell.data.count * sizeof(float));
+          aggregateLevelOfDetail(*t.topology, t.cell.data.data, t.lod.cell.data.data);
+        }
+      }
+    }
+  }
+
+  // Differences are computed once here, like the per-timestep cell data,
+  // so that stepping through timesteps only swaps volumes. A dataset whose
+  // mesh differs from dataset 0 at any timestep shows its own data on the
+  // regular scale instead.
+  if (ui.difference.enabled && ui.coprocess.created.completed == 0) {
+    for (size_t k=1; k<datasets.d.size(); ++k) {
+      auto &difference = datasets.d[k].difference;
+      difference.enabled = true;
+      difference.minimum = 0.0f;
+      difference.maximum = 0.0f;
+      for (size_t i=0; i<datasets.timesteps; ++i) {
+        auto &a = datasets.d[k].timesteps.t[i];
+        arena.release(a.difference.data);
+        a.difference.data = nullptr;
+        arena.release(a.difference.lod);
+        a.difference.lod = nullptr;
+        if (a.topology != datasets.d[0].timesteps.t[i].topology) {
+          difference.enabled = false;
+        }
+      }
+      if (!difference.enabled) {
+        std::fprintf(stderr, "Dataset %zu: mesh differs from dataset 0, not showing difference\n", k);
+        continue;
+      }
+
+      for (size_t i=0; i<datasets.timesteps; ++i) {
+        auto &a = datasets.d[k].timesteps.t[i];
+        auto &b = datasets.d[0].timesteps.t[i];
+        a.difference.data = (float *)arena.allocate(a.cell.data.count * sizeof(float));
+        for (size_t j=0; j<a.cell.data.count; ++j) {
+          float d = a.cell.data.data[j] - b.cell.data.data[j];
+          a.difference.data[j] = d;
+          difference.minimum = std::min(difference.minimum, d);
+          difference.maximum = std::max(difference.maximum, d);
+        }
+
+        if (ui.lod.enabled) {
+          a.difference.lod = (float *)arena.allocate(a.lod.cell.data.count * sizeof(float));
+          aggregateLevelOfDetail(*a.topology, a.difference.data, a.difference.lod);
+        }
+      }
+    }
+  }
+
+  // Resume after the last fully created timestep (0 on the first run)
+  for (size_t n=ui.coprocess.created.completed; n<total; ++n) {
+    ui.coprocess.created.completed = n;
+    if (ui.coprocess.cancelled) {
+      std::fprintf(stderr, "Create cancelled at timestep %zu\n", n);
+      return;
+    }
+
+    size_t k = n / datasets.timesteps;
+    size_t i = n % datasets.timesteps;
+    auto &timesteps = datasets.d[k].timesteps;
+    bool showsDifference = ui.difference.enabled && k != 0 && datasets.d[k].difference.enabled;
+    const float *data = timesteps.t[i].cell.data.data;
+    const float *lodData = timesteps.t[i].lod.cell.data.data;
+    range1f valueRange(timesteps.t[i].cell.data.minimum, timesteps.t[i].cell.data.maximum);
+    if (showsDifference) {
+      data = timesteps.t[i].difference.data;
+      lodData = timesteps.t[i].difference.lod;
+      valueRange = range1f(datasets.d[k].difference.minimum, datasets.d[k].difference.maximum);
+    }
 
     if (ui.geometry.mode == ui.geometry.SEPARATE_WORLDS) {
-      std::string name(128, '\0');
-      std::snprintf(const_cast<char *>(name.data()), 128, SG_PREFIX("world_%s"), timesteps.t[i].name.c_str());
-      timesteps.t[i].world.node = sg::createNode(name, "world");
+      if (k == 0) {
+        std::string name(128, '\0');
+        std::snprintf(const_cast<char *>(name.data()), 128, SG_PREFIX("world_%s"), timesteps.t[i].name.c_str());
+        timesteps.t[i].world.node = sg::createNode(name, "world");
+      } else {
+        // All datasets at one timestep share the world the slider selects
+        timesteps.t[i].world.node = datasets.d[0].timesteps.t[i].world.node;
+      }
     } else if (ui.geometry.mode == ui.geometry.SAME_WORLD) {
       timesteps.t[i].world.node = context->frame->childNodeAs<sg::Node>("world");
     } else {
@@ -461,54 +1227,98 @@ void PanelMikr::createGeometry() {
     auto &world = *timesteps.t[i].world.node; {
       if (ui.tfn.mode == ui.tfn.SEPARATE_TRANSFER_FUNCTIONS) {
         std::string name(128, '\0');
-        std::snprintf(const_cast<char *>(name.data()), 128, SG_PREFIX("tfn_%s"), timesteps.t[i].name.c_str());
+        std::snprintf(const_cast<char *>(name.data()), 128, SG_PREFIX("tfn_%zu_%s"), k, timesteps.t[i].name.c_str());
         timesteps.t[i].world.tfn.node = sg::createNode(name, "transfer_function_viridis");
       } else if (ui.tfn.mode == ui.tfn.SAME_TRANSFER_FUNCTION) {
-        if (i == 0) {
+        if (showsDifference && i == 0) {
+          std::string name(128, '\0');
+          std::snprintf(const_cast<char *>(name.data()), 128, SG_PREFIX("tfn_difference_%zu"), k);
+          timesteps.t[i].world.tfn.node = sg::createNode(name, "transfer_function_viridis");
+        } else if (showsDifference) {
+          timesteps.t[i].world.tfn.node = timesteps.t[0].world.tfn.node;
+        } else if (n == 0) {
           timesteps.t[i].world.tfn.node = sg::createNode(SG_PREFIX("tfn"), "transfer_function_viridis");
         } else {
-          timesteps.t[i].world.tfn.node = timesteps.t[0].world.tfn.node;
+          timesteps.t[i].world.tfn.node = datasets.d[0].timesteps.t[0].world.tfn.node;
         }
       } else {
         throw NotImplemented();
       }
 
       auto &tfn = *timesteps.t[i].world.tfn.node; {
-        tfn["valueRange"] = vec2f(timesteps.cell.data.minimum, timesteps.cell.data.maximum);
+        if (showsDifference) {
+          tfn["valueRange"] = vec2f(datasets.d[k].difference.minimum, datasets.d[k].difference.maximum);
+        } else {
+          tfn["valueRange"] = vec2f(datasets.cell.data.minimum, datasets.cell.data.maximum);
+        }
 
         {
           std::string name(128, '\0');
-          std::snprintf(const_cast<char *>(name.data()), 128, SG_PREFIX("xfm_%s"), timesteps.t[i].name.c_str());
+          std::snprintf(const_cast<char *>(name.data()), 128, SG_PREFIX("xfm_%zu_%s"), k, timesteps.t[i].name.c_str());
           timesteps.t[i].world.tfn.xfm.node = sg::createNode(name, "transform");
         }
 
         auto &xfm = *timesteps.t[i].world.tfn.xfm.node; {
+          xfm["translation"] = (float)k * spacing;
           {
             std::string name(128, '\0');
-            std::snprintf(const_cast<char *>(name.data()), 128, SG_PREFIX("vol_%s"), timesteps.t[i].name.c_str());
+            std::snprintf(const_cast<char *>(name.data()), 128, SG_PREFIX("vol_%zu_%s"), k, timesteps.t[i].name.c_str());
             timesteps.t[i].world.tfn.xfm.vol.node = sg::createNode(name, "volume_unstructured");
           }
+          auto &topology = *timesteps.t[i].topology;
           auto &vol = *timesteps.t[i].world.tfn.xfm.vol.node; {
-            vol["valueRange"] = range1f(timesteps.t[i].cell.data.minimum, timesteps.t[i].cell.data.maximum);
+            vol["valueRange"] = valueRange;
             vol.child("valueRange").setSGOnly();
             vol.remove("vertex.data");
             vol.createChildData("vertex.position",
-                                timesteps.t[i].vertex.position.count,
-                                timesteps.t[i].vertex.position.data);
+                                topology.vertex.position.count,
+                                topology.vertex.position.data);
             vol.createChildData("index",
-                                timesteps.t[i].index.count,
-                                timesteps.t[i].index.data);
+                                topology.index.count,
+                                topology.index.data);
             vol.createChildData("cell.index",
-                                timesteps.t[i].cell.index.count,
-                                timesteps.t[i].cell.index.data);
+                                topology.cell.index.count,
+                                topology.cell.index.data);
             vol.createChildData("cell.type",
-                                timesteps.t[i].cell.type.count,
-                                timesteps.t[i].cell.type.data);
+                                topology.cell.type.count,
+                                topology.cell.type.data);
             vol.createChildData("cell.data",
                                 timesteps.t[i].cell.data.count,
-                                timesteps.t[i].cell.data.data);
+                                data);
+            // Only the first timestep shows until creation finishes, so a
+            // cancelled create does not leave every timestep overlaid
+            vol.child("visible") = i == 0;
           } vol.commit();
           xfm.add(vol);
+          timesteps.t[i].world.tfn.xfm.lod.node = nullptr;
+          if (ui.lod.enabled) {
+            std::string name(128, '\0');
+            std::snprintf(const_cast<char *>(name.data()), 128, SG_PREFIX("lod_%zu_%s"), k, timesteps.t[i].name.c_str());
+            timesteps.t[i].world.tfn.xfm.lod.node = sg::createNode(name, "volume_unstructured");
+
+            auto &lod = *timesteps.t[i].world.tfn.xfm.lod.node; {
+              lod["valueRange"] = valueRange;
+              lod.child("valueRange").setSGOnly();
+              lod.remove("vertex.data");
+              lod.createChildData("vertex.position",
+                                  topology.lod.vertex.position.count,
+                                  topology.lod.vertex.position.data);
+              lod.createChildData("index",
+                                  topology.lod.index.count,
+                                  topology.lod.index.data);
+              lod.createChildData("cell.index",
+                                  topology.lod.cell.index.count,
+                                  topology.lod.cell.index.data);
+              lod.createChildData("cell.type",
+                                  topology.lod.cell.type.count,
+                                  topology.lod.cell.type.data);
+              lod.createChildData("cell.data",
+                                  timesteps.t[i].lod.cell.data.count,
+                                  lodData);
+              lod.child("visible") = false;
+            } lod.commit();
+            xfm.add(lod);
+          }
         } xfm.commit();
         tfn.add(xfm);
       } tfn.commit();
@@ -516,25 +1326,310 @@ void PanelMikr::createGeometry() {
     } world.commit();
   }
 
+  ui.lod.active = false;
   if (ui.geometry.mode == ui.geometry.SEPARATE_WORLDS) {
-    context->frame->add(timesteps.t[0].world.node, "world");
+    context->frame->add(datasets.d[0].timesteps.t[0].world.node, "world");
+    for (size_t k=0; k<datasets.d.size(); ++k) {
+      for (size_t i=0; i<datasets.timesteps; ++i) {
+        setVisible(k, i, true);
+      }
+    }
   } else if (ui.geometry.mode == ui.geometry.SAME_WORLD) {
-    timesteps.t[0].world.tfn.xfm.vol.node->child("visible") = true;
-    for (size_t i=1; i<timesteps.count; ++i) {
-      timesteps.t[i].world.tfn.xfm.vol.node->child("visible") = false;
+    for (size_t k=0; k<datasets.d.size(); ++k) {
+      setVisible(k, 0, true);
+      for (size_t i=1; i<datasets.timesteps; ++i) {
+        setVisible(k, i, false);
+      }
     }
   } else {
     throw NotImplemented();
   }
 
-  ui.coprocess.created.completed = timesteps.count;
+  ui.coprocess.created.completed = total;
 
   context->frame->traverse<sg::PrintNodes>();
 }
 #undef SG_PREFIX
 
+void PanelMikr::showTimestep(size_t previous, size_t current) {
+  if (ui.geometry.mode == ui.geometry.SEPARATE_WORLDS) {
+    context->frame->add(datasets.d[0].timesteps.t[current].world.node, "world");
+    for (size_t k=0; k<datasets.d.size(); ++k) {
+      setVisible(k, current, true);
+    }
+  } else if (ui.geometry.mode == ui.geometry.SAME_WORLD) {
+    for (size_t k=0; k<datasets.d.size(); ++k) {
+      setVisible(k, previous, false);
+      setVisible(k, current, true);
+    }
+  } else {
+    assert(0);
+  }
+}
+
+void PanelMikr::setVisible(size_t k, size_t i, bool visible) {
+  auto &xfm = datasets.d[k].timesteps.t[i].world.tfn.xfm;
+  bool useLod = ui.lod.active && xfm.lod.node;
+  xfm.vol.node->child("visible").setValue(visible && !useLod);
+  if (xfm.lod.node) {
+    xfm.lod.node->child("visible").setValue(visible && useLod);
+  }
+}
+
+void PanelMikr::buildLevelOfDetail(Topology &topology) {
+  auto &lod = topology.lod;
+  size_t cells = topology.cell.index.count;
+
+  std::fprintf(stderr, "Build LOD\n");
+
+  // Bin size: a few times the average fine cell extent along each axis
+  vec3f extent(0.0f);
+  for (size_t c=0; c<cells; ++c) {
+    const uint32_t *index = topology.index.data + topology.cell.index.data[c];
+    vec3f minimum = topology.vertex.position.data[index[0]];
+    vec3f maximum = minimum;
+    for (size_t v=1; v<8; ++v) {
+      minimum = min(minimum, topology.vertex.position.data[index[v]]);
+      maximum = max(maximum, topology.vertex.position.data[index[v]]);
+    }
+    extent = extent + (maximum - minimum);
+  }
+  vec3f size = (float)ui.lod.factor * extent / (float)std::max(cells, (size_t)1);
+  vec3f origin = topology.vertex.position.minimum;
+  vec3f span = topology.vertex.position.maximum - origin;
+  size_t dims[3];
+  for (int a=0; a<3; ++a) {
+    if (!(size[a] > 0.0f)) {
+      size[a] = std::max(span[a], 1.0f);
+    }
+    dims[a] = std::max((size_t)std::ceil(span[a] / size[a]), (size_t)1);
+  }
+
+  // Only occupied bins become coarse cells
+  std::unordered_map<size_t, uint32_t> bins;
+  std::vector<vec3f> minima;
+  std::vector<vec3f> maxima;
+  lod.map = (uint32_t *)arena.allocate(cells * sizeof(uint32_t));
+  for (size_t c=0; c<cells; ++c) {
+    const uint32_t *index = topology.index.data + topology.cell.index.data[c];
+    vec3f minimum = topology.vertex.position.data[index[0]];
+    vec3f maximum = minimum;
+    for (size_t v=1; v<8; ++v) {
+      minimum = min(minimum, topology.vertex.position.data[index[v]]);
+      maximum = max(maximum, topology.vertex.position.data[index[v]]);
+    }
+
+    size_t bin = 0;
+    for (int a=2; a>=0; --a) {
+      float centroid = 0.5f * (minimum[a] + maximum[a]);
+      size_t b = (size_t)std::max(0.0f, (centroid - origin[a]) / size[a]);
+      bin = bin * dims[a] + std::min(b, dims[a] - 1);
+    }
+
+    auto it = bins.emplace(bin, (uint32_t)bins.size());
+    if (it.second) {
+      minima.push_back(minimum);
+      maxima.push_back(maximum);
+    }
+    uint32_t coarse = it.first->second;
+    minima[coarse] = min(minima[coarse], minimum);
+    maxima[coarse] = max(maxima[coarse], maximum);
+    lod.map[c] = coarse;
+  }
+
+  lod.count = bins.size();
+  lod.members = (uint32_t *)arena.allocate(lod.count * sizeof(uint32_t));
+  std::fill(lod.members, lod.members + lod.count, 0);
+  for (size_t c=0; c<cells; ++c) {
+    ++lod.members[lod.map[c]];
+  }
+
+  lod.vertex.position.count = 8 * lod.count;
+  lod.vertex.position.data = (vec3f *)arena.allocate(lod.vertex.position.count * sizeof(vec3f));
+  lod.index.count = 8 * lod.count;
+  lod.index.data = (uint32_t *)arena.allocate(lod.index.count * sizeof(uint32_t));
+  lod.cell.index.count = lod.count;
+  lod.cell.index.data = (uint32_t *)arena.allocate(lod.cell.index.count * sizeof(uint32_t));
+  lod.cell.type.count = lod.count;
+  lod.cell.type.data = (uint8_t *)arena.allocate(lod.cell.type.count * sizeof(uint8_t));
+  for (size_t c=0; c<lod.count; ++c) {
+    const vec3f &lo = minima[c];
+    const vec3f &hi = maxima[c];
+    vec3f *position = lod.vertex.position.data + 8 * c;
+    // Same corner order as plugin_mikr.py: bottom, then top, each
+    // counterclockwise
+    position[0] = vec3f(lo.x, lo.y, lo.z);
+    position[1] = vec3f(hi.x, lo.y, lo.z);
+    position[2] = vec3f(hi.x, hi.y, lo.z);
+    position[3] = vec3f(lo.x, hi.y, lo.z);
+    position[4] = vec3f(lo.x, lo.y, hi.z);
+    position[5] = vec3f(hi.x, lo.y, hi.z);
+    position[6] = vec3f(hi.x, hi.y, hi.z);
+    position[7] = vec3f(lo.x, hi.y, hi.z);
+    for (size_t v=0; v<8; ++v) {
+      lod.index.data[8 * c + v] = 8 * c + v;
+    }
+    lod.cell.index.data[c] = 8 * c;
+    lod.cell.type.data[c] = 12; // OSP_HEXAHEDRON
+  }
+
+  std::fprintf(stderr, "LOD: %zu cells -> %zu cells\n", cells, lod.count);
+}
+
+void PanelMikr::aggregateLevelOfDetail(const Topology &topology, const float *fine, float *coarse) {
+  const auto &lod = topology.lod;
+  size_t cells = topology.cell.index.count;
+
+  if (ui.lod.aggregate == ui.lod.MAXIMUM) {
+    std::fill(coarse, coarse + lod.count, -FLT_MAX);
+    for (size_t c=0; c<cells; ++c) {
+      coarse[lod.map[c]] = std::max(coarse[lod.map[c]], fine[c]);
+    }
+  } else if (ui.lod.aggregate == ui.lod.MEAN) {
+    std::fill(coarse, coarse + lod.count, 0.0f);
+    for (size_t c=0; c<cells; ++c) {
+      coarse[lod.map[c]] += fine[c];
+    }
+    for (size_t c=0; c<lod.count; ++c) {
+      coarse[c] /= (float)lod.members[c];
+    }
+  } else {
+    throw NotImplemented();
+  }
+}
+
 void PanelMikr::stopCoProcess() {
   std::fprintf(stderr, "Stop\n");
+
+  for (size_t k=0; k<datasets.d.size(); ++k) {
+    auto &coprocess = datasets.d[k].coprocess;
+
+    if (coprocess.stdin) {
+      // plugin_mikr.py exits its request loop on a negative timestep index
+      ssize_t temp = -1;
+      fwrite(&temp, sizeof(temp), 1, coprocess.stdin);
+      fclose(coprocess.stdin);
+      coprocess.stdin = nullptr;
+    }
+    if (coprocess.stdout) {
+      fclose(coprocess.stdout);
+      coprocess.stdout = nullptr;
+    }
+
+    if (coprocess.pid > 0) {
+      using namespace std::literals::chrono_literals;
+      int status;
+      time_point deadline = clock::now() + 2s;
+      while (waitpid(coprocess.pid, &status, WNOHANG) == 0) {
+        if (clock::now() >= deadline) {
+          std::fprintf(stderr, "Co-process %d did not exit, killing it\n", coprocess.pid);
+          kill(coprocess.pid, SIGKILL);
+          waitpid(coprocess.pid, &status, 0);
+          break;
+        }
+        std::this_thread::sleep_for(10ms);
+      }
+      coprocess.pid = 0;
+    }
+  }
+}
+
+void PanelMikr::cancelCoProcess() {
+  std::fprintf(stderr, "Cancel\n");
+
+  ui.coprocess.cancelled = true;
+
+  // Transfer and create stop at the next timestep boundary on their own,
+  // but the co-processes do not listen while they parse the datasets, so
+  // the only way to interrupt loading is to end them.
+  if (ui.coprocess.state.next == ui.coprocess.state.LOADED_ACTIVE) {
+    for (size_t k=0; k<datasets.d.size(); ++k) {
+      if (datasets.d[k].coprocess.pid > 0) {
+        kill(datasets.d[k].coprocess.pid, SIGTERM);
+      } else if (datasets.d[k].coprocess.stdout) {
+        // The loader service is shared, so only drop our connection to it
+        shutdown(fileno(datasets.d[k].coprocess.stdout), SHUT_RDWR);
+      }
+    }
+  }
+}
+
+void PanelMikr::releaseGeometry() {
+  std::fprintf(stderr, "Release geometry\n");
+
+  if (ui.coprocess.created.completed == 0) {
+    return;
+  }
+
+  size_t total = datasets.timesteps * datasets.d.size();
+  if (ui.geometry.mode == ui.geometry.SEPARATE_WORLDS) {
+    // Once creation finished, the frame holds one of our per-timestep
+    // worlds; give it a fresh one
+    if (ui.coprocess.created.completed == total) {
+      context->frame->add(sg::createNode("world", "world"));
+    }
+  } else if (ui.geometry.mode == ui.geometry.SAME_WORLD) {
+    for (size_t n=0; n<ui.coprocess.created.completed; ++n) {
+      auto &t = datasets.d[n / datasets.timesteps].timesteps.t[n % datasets.timesteps];
+      auto &world = *t.world.node;
+      auto &tfn = *t.world.tfn.node;
+      if (world.hasChild(tfn.name())) {
+        world.remove(tfn.name());
+      }
+    }
+  } else {
+    throw NotImplemented();
+  }
+
+  for (size_t n=0; n<ui.coprocess.created.completed; ++n) {
+    auto &t = datasets.d[n / datasets.timesteps].timesteps.t[n % datasets.timesteps];
+    t.world.tfn.xfm.vol.node = nullptr;
+    t.world.tfn.xfm.lod.node = nullptr;
+    t.world.tfn.xfm.node = nullptr;
+    t.world.tfn.node = nullptr;
+    t.world.node = nullptr;
+  }
+
+  ui.coprocess.created.completed = 0;
+  ui.timestep.index.current = 0;
+  ui.timestep.index.previous = 0;
+}
+
+void PanelMikr::releaseTimesteps() {
+  std::fprintf(stderr, "Release timesteps\n");
+
+  // Returned to the arena, so the next dataset reuses the same slabs
+  for (size_t k=0; k<datasets.d.size(); ++k) {
+    auto &timesteps = datasets.d[k].timesteps;
+    for (size_t i=0; i<timesteps.t.size(); ++i) {
+      arena.release(timesteps.t[i].cell.data.data);
+      arena.release(timesteps.t[i].lod.cell.data.data);
+      arena.release(timesteps.t[i].difference.data);
+      arena.release(timesteps.t[i].difference.lod);
+    }
+    timesteps.t.clear();
+    timesteps.count = 0;
+  }
+
+  for (auto &g : topologies.g) {
+    arena.release(g->vertex.position.data);
+    arena.release(g->index.data);
+    arena.release(g->cell.index.data);
+    arena.release(g->cell.type.data);
+    arena.release(g->lod.map);
+    arena.release(g->lod.members);
+    arena.release(g->lod.vertex.position.data);
+    arena.release(g->lod.index.data);
+    arena.release(g->lod.cell.index.data);
+    arena.release(g->lod.cell.type.data);
+  }
+  topologies.g.clear();
+
+  datasets.timesteps = 0;
+  datasets.nbytes = 0;
+  ui.coprocess.loaded.completed = 0;
+  ui.coprocess.transferred.completed = 0;
+  ui.coprocess.created.completed = 0;
 }
 
 }  // namespace mikr_plugin
@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include "TimestepArena.h"
+
 #include "app/widgets/Panel.h"
 #include "app/ospStudio.h"
 #include "rkcommon/tasking/AsyncTask.h"
@@ -24,15 +26,21 @@ public:
 struct PanelMikr : public Panel
 {
   PanelMikr(std::shared_ptr<StudioContext> context,
-            std::string optDefaultFilename);
+            std::vector<std::string> optDefaultFilenames);
+  ~PanelMikr() override;
 
   void buildUI(void *ImGuiCtx) override;
 
+  void setRegionOfInterestFromCamera();
+
   void startCoProcess();
-  void loadInCoProcess();
-  void transferFromCoProcess();
+  bool loadInCoProcess();
+  bool transferFromCoProcess();
   void createGeometry();
   void stopCoProcess();
+  void cancelCoProcess();
+  void releaseGeometry();
+  void releaseTimesteps();
 
 protected:
   using clock = std::chrono::system_clock;
@@ -40,10 +48,17 @@ protected:
   using duration = std::chrono::duration<float>;
   using Task = rkcommon::tasking::AsyncTask<void>;
 
+  bool readFromCoProcess(size_t k, void *data, size_t nbytes);
+  bool writeToCoProcess(size_t k, const void *data, size_t nbytes);
+  std::string scriptPath();
+  int connectToDaemon();
+  std::string resolveDatasetPath(std::string filename);
+  void spawnDaemon();
+  void showTimestep(size_t previous, size_t current);
+  void setVisible(size_t k, size_t i, bool visible);
+
   struct {
     struct {
-      std::string filename; // ui.coprocess.filename
-
       struct {
         enum _S {
           INITED, // ui.coprocess.state.INITED
@@ -64,6 +79,8 @@ protected:
         std::atomic<_S> next; // ui.coprocess.state.next
       } state; // ui.coprocess.state
 
+      std::atomic<bool> cancelled; // ui.coprocess.cancelled
+
       struct {
         std::unique_ptr<Task> task; // ui.coprocess.started.task
       } started; // ui.coprocess.started
@@ -88,6 +105,11 @@ protected:
       } stopped; // ui.coprocess.stopped
     } coprocess; // ui.coprocess
 
+    struct {
+      bool enabled; // ui.daemon.enabled
+      std::string socket; // ui.daemon.socket
+    } daemon; // ui.daemon
+
     struct {
       enum {
         SEPARATE_WORLDS, // ui.geometry.SEPARATE_WORLDS
@@ -102,6 +124,34 @@ protected:
       } mode; // ui.tfn.mode
     } tfn; // ui.tfn
 
+    struct {
+      enum {
+        OVERLAID, // ui.layout.OVERLAID
+        SIDE_BY_SIDE, // ui.layout.SIDE_BY_SIDE
+      } mode; // ui.layout.mode
+    } layout; // ui.layout
+
+    struct {
+      bool enabled; // ui.difference.enabled
+    } difference; // ui.difference
+
+    struct {
+      bool enabled; // ui.lod.enabled
+      bool active; // ui.lod.active
+      int factor; // ui.lod.factor
+
+      enum {
+        MAXIMUM, // ui.lod.MAXIMUM
+        MEAN, // ui.lod.MEAN
+      } aggregate; // ui.lod.aggregate
+    } lod; // ui.lod
+
+    struct {
+      bool enabled; // ui.roi.enabled
+      vec3f minimum; // ui.roi.minimum
+      vec3f maximum; // ui.roi.maximum
+    } roi; // ui.roi
+
     struct {
       struct {
         size_t current; // ui.timestep.index.current
@@ -125,73 +175,179 @@ protected:
     } animation; // ui.animation
   } ui;
 
-  struct {
-    int pid; // coprocess.pid
-    FILE *stdin; // coprocess.stdin
-    FILE *stdout; // coprocess.stdout
-  } coprocess;
+  TimestepArena arena; // timestep buffers
 
+  // Mesh arrays, deduplicated by the digest the co-process sends ahead of
+  // them, so that timesteps and datasets on the same mesh share one copy.
   struct {
-    size_t count; // timesteps.count
-    size_t nbytes; // timesteps.nbytes
+    struct _G;
+    std::vector<std::unique_ptr<_G>> g; // topologies.g[j]
+    struct _G {
+      char digest[16]; // topologies.g[j]->digest
 
-    struct {
       struct {
-        float minimum; // timesteps.cell.data.minumum
-        float maximum; // timesteps.cell.data.maximum
-      } data; // timesteps.cell.data
-    } cell; // timesteps.cell
+        struct {
+          size_t count; // topologies.g[j]->vertex.position.count
+          vec3f *data; // topologies.g[j]->vertex.position.data
+          vec3f minimum; // topologies.g[j]->vertex.position.minimum
+          vec3f maximum; // topologies.g[j]->vertex.position.maximum
+        } position; // topologies.g[j]->vertex.position
+      } vertex; // topologies.g[j]->vertex
 
-    struct _T;
-    std::vector<_T> t; // timesteps.t[i]
-    struct _T {
-      std::string name; // timesteps.t[i].name
+      struct {
+        size_t count; // topologies.g[j]->index.count
+        uint32_t *data; // topologies.g[j]->index.data
+      } index; // topologies.g[j]->index
 
       struct {
-        sg::NodePtr node; // timesteps.t[i].world.node
         struct {
-          sg::NodePtr node; // timesteps.t[i].world.tfn.node
+          size_t count; // topologies.g[j]->cell.index.count
+          uint32_t *data; // topologies.g[j]->cell.index.data
+        } index; // topologies.g[j]->cell.index
+        struct {
+          size_t count; // topologies.g[j]->cell.type.count
+          uint8_t *data; // topologies.g[j]->cell.type.data
+        } type; // topologies.g[j]->cell.type
+      } cell; // topologies.g[j]->cell
+
+      // Coarse mesh: fine cells are binned by centroid on a grid a few
+      // cells wide, and every occupied bin becomes one hexahedron that
+      // bounds its members.
+      struct {
+        size_t count; // topologies.g[j]->lod.count
+        uint32_t *map; // topologies.g[j]->lod.map (fine cell -> coarse cell)
+        uint32_t *members; // topologies.g[j]->lod.members (per coarse cell)
+
+        struct {
           struct {
-            sg::NodePtr node; // timesteps.t[i].world.tfn.xfm.node
-            struct {
-              sg::NodePtr node; // timesteps.t[i].world.tfn.xfm.vol.node
-            } vol; // timesteps.t[i].world.tfn.xfm.vol
-          } xfm; // timesteps.t[i].world.tfn.xfm
-        } tfn; // timesteps.t[i].world.tfn
-      } world; // timesteps.t[i].world
+            size_t count; // topologies.g[j]->lod.vertex.position.count
+            vec3f *data; // topologies.g[j]->lod.vertex.position.data
+          } position; // topologies.g[j]->lod.vertex.position
+        } vertex; // topologies.g[j]->lod.vertex
 
-      struct {
         struct {
-          size_t count; // timesteps.t[i].vertex.position.count
-          vec3f *data; // timesteps.t[i].vertex.position.data
-          vec3f minimum; // timesteps.t[i].vertex.position.minimum
-          vec3f maximum; // timesteps.t[i].vertex.position.maximum
-        } position; // timesteps.t[i].vertex.position
-      } vertex; // timesteps.t[i].vertex
+          size_t count; // topologies.g[j]->lod.index.count
+          uint32_t *data; // topologies.g[j]->lod.index.data
+        } index; // topologies.g[j]->lod.index
+
+        struct {
+          struct {
+            size_t count; // topologies.g[j]->lod.cell.index.count
+            uint32_t *data; // topologies.g[j]->lod.cell.index.data
+          } index; // topologies.g[j]->lod.cell.index
+          struct {
+            size_t count; // topologies.g[j]->lod.cell.type.count
+            uint8_t *data; // topologies.g[j]->lod.cell.type.data
+          } type; // topologies.g[j]->lod.cell.type
+        } cell; // topologies.g[j]->lod.cell
+      } lod; // topologies.g[j]->lod
+    };
+  } topologies;
+
+  struct {
+    size_t timesteps; // datasets.timesteps (common to all datasets)
+    size_t nbytes; // datasets.nbytes
 
+    struct {
       struct {
-        size_t count; // timesteps.t[i].index.count
-        uint32_t *data; // timesteps.t[i].index.data
-      } index; // timesteps.t[i].index
+        vec3f minimum; // datasets.vertex.position.minimum
+        vec3f maximum; // datasets.vertex.position.maximum
+      } position; // datasets.vertex.position
+    } vertex; // datasets.vertex
 
+    struct {
       struct {
+        float minimum; // datasets.cell.data.minimum
+        float maximum; // datasets.cell.data.maximum
+      } data; // datasets.cell.data
+    } cell; // datasets.cell
+
+    struct _D;
+    std::vector<_D> d; // datasets.d[k]
+    struct _D {
+      std::string filename; // datasets.d[k].filename
+
+      struct {
+        int pid; // datasets.d[k].coprocess.pid
+        FILE *stdin; // datasets.d[k].coprocess.stdin
+        FILE *stdout; // datasets.d[k].coprocess.stdout
+      } coprocess; // datasets.d[k].coprocess
+
+      struct {
+        bool enabled; // datasets.d[k].difference.enabled (same mesh as dataset 0 throughout)
+        float minimum; // datasets.d[k].difference.minimum
+        float maximum; // datasets.d[k].difference.maximum
+      } difference; // datasets.d[k].difference
+
+      struct {
+        size_t count; // datasets.d[k].timesteps.count
+
         struct {
-          size_t count; // timesteps.t[i].cell.index.count
-          uint32_t *data; // timesteps.t[i].cell.index.data
-        } index; // timesteps.t[i].cell.index
-        struct {
-          size_t count; // timesteps.t[i].cell.type.count
-          uint8_t *data; // timesteps.t[i].cell.type.data
-        } type; // timesteps.t[i].cell.type
-        struct {
-          size_t count; // timesteps.t[i].cell.data.count
-          float *data; // timesteps.t[i].cell.data.data
-          float minimum; // timesteps.t[i].cell.data.minimum
-          float maximum; // timesteps.t[i].cell.data.maximum
-        } data; // timesteps.t[i].cell.data
-      } cell; // timesteps.t[i].cell
+          struct {
+            vec3f minimum; // datasets.d[k].timesteps.vertex.position.minimum
+            vec3f maximum; // datasets.d[k].timesteps.vertex.position.maximum
+          } position; // datasets.d[k].timesteps.vertex.position
+        } vertex; // datasets.d[k].timesteps.vertex
+
+        struct _T;
+        std::vector<_T> t; // datasets.d[k].timesteps.t[i]
+        struct _T {
+          std::string name; // datasets.d[k].timesteps.t[i].name
+          size_t index; // datasets.d[k].timesteps.t[i].index (in the co-process)
+
+          struct {
+            sg::NodePtr node; // datasets.d[k].timesteps.t[i].world.node
+            struct {
+              sg::NodePtr node; // datasets.d[k].timesteps.t[i].world.tfn.node
+              struct {
+                sg::NodePtr node; // datasets.d[k].timesteps.t[i].world.tfn.xfm.node
+                struct {
+                  sg::NodePtr node; // datasets.d[k].timesteps.t[i].world.tfn.xfm.vol.node
+                } vol; // datasets.d[k].timesteps.t[i].world.tfn.xfm.vol
+                struct {
+                  sg::NodePtr node; // datasets.d[k].timesteps.t[i].world.tfn.xfm.lod.node
+                } lod; // datasets.d[k].timesteps.t[i].world.tfn.xfm.lod
+              } xfm; // datasets.d[k].timesteps.t[i].world.tfn.xfm
+            } tfn; // datasets.d[k].timesteps.t[i].world.tfn
+          } world; // datasets.d[k].timesteps.t[i].world
+
+          decltype(topologies)::_G *topology; // datasets.d[k].timesteps.t[i].topology
+
+          struct {
+            struct {
+              size_t count; // datasets.d[k].timesteps.t[i].cell.data.count
+              float *data; // datasets.d[k].timesteps.t[i].cell.data.data
+              float minimum; // datasets.d[k].timesteps.t[i].cell.data.minimum
+              float maximum; // datasets.d[k].timesteps.t[i].cell.data.maximum
+            } data; // datasets.d[k].timesteps.t[i].cell.data
+          } cell; // datasets.d[k].timesteps.t[i].cell
+
+          struct {
+            struct {
+              struct {
+                size_t count; // datasets.d[k].timesteps.t[i].lod.cell.data.count
+                float *data; // datasets.d[k].timesteps.t[i].lod.cell.data.data
+              } data; // datasets.d[k].timesteps.t[i].lod.cell.data
+            } cell; // datasets.d[k].timesteps.t[i].lod.cell
+          } lod; // datasets.d[k].timesteps.t[i].lod
+
+          // Against dataset 0 at the same timestep, computed at create time
+          // for datasets shown as a difference on the same mesh
+          struct {
+            float *data; // datasets.d[k].timesteps.t[i].difference.data (cell.data.count values)
+            float *lod; // datasets.d[k].timesteps.t[i].difference.lod (lod.cell.data.count values)
+          } difference; // datasets.d[k].timesteps.t[i].difference
+        };
+      } timesteps; // datasets.d[k].timesteps
     };
-  } timesteps;
+  } datasets;
+
+  using Dataset = decltype(datasets)::_D;
+  void initDataset(Dataset &dataset);
+
+  using Topology = decltype(topologies)::_G;
+  void buildLevelOfDetail(Topology &topology);
+  void aggregateLevelOfDetail(const Topology &topology, const float *fine, float *coarse);
 };
 
 }  // namespace mikr_plugin
@@ -0,0 +1,165 @@
+// Copyright 2009-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#include "TimestepArena.h"
+
+#include <cstdio>
+#include <new>
+
+#include <sys/mman.h>
+
+namespace ospray {
+namespace mikr_plugin {
+
+static constexpr size_t hugePageSize = 2ul << 20;
+
+TimestepArena::TimestepArena(size_t slabSize, bool useHugePages)
+  : slabSize(slabSize), useHugePages(useHugePages)
+{
+  nbytes.used = 0;
+  nbytes.reserved = 0;
+}
+
+TimestepArena::~TimestepArena()
+{
+  clear();
+}
+
+size_t TimestepArena::round(size_t nbytes)
+{
+  return (nbytes + alignment - 1) / alignment * alignment;
+}
+
+size_t TimestepArena::addSlab(size_t nbytes)
+{
+  size_t capacity = nbytes < slabSize ? slabSize : nbytes;
+  capacity = (capacity + hugePageSize - 1) / hugePageSize * hugePageSize;
+
+  // mmap is page aligned, which covers the 64-byte alignment of the blocks
+  void *data = mmap(nullptr, capacity, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (data == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+#ifdef MADV_HUGEPAGE
+  if (useHugePages) {
+    // Only a hint: fails quietly when THP is disabled system-wide
+    madvise(data, capacity, MADV_HUGEPAGE);
+  }
+#endif
+
+  std::fprintf(stderr, "Arena: new slab of %zuMB\n", capacity / 1024ul / 1024ul);
+
+  slabs.push_back({(char *)data, capacity, 0, 0});
+  this->nbytes.reserved += capacity;
+  return slabs.size() - 1;
+}
+
+void TimestepArena::reserve(size_t nbytes)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  nbytes = round(nbytes);
+  for (const _S &slab : slabs) {
+    if (slab.capacity - slab.offset >= nbytes) {
+      return;
+    }
+  }
+  addSlab(nbytes);
+}
+
+void *TimestepArena::allocate(size_t nbytes)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  nbytes = round(nbytes);
+  if (nbytes == 0) {
+    nbytes = alignment;
+  }
+
+  // Best fit among released blocks first
+  auto it = released.lower_bound(nbytes);
+  if (it != released.end()) {
+    void *data = it->second;
+    released.erase(it);
+    _B &block = blocks.at(data);
+    ++slabs[block.slab].live;
+    this->nbytes.used += block.capacity;
+    return data;
+  }
+
+  size_t s = slabs.size();
+  for (size_t i=0; i<slabs.size(); ++i) {
+    if (slabs[i].capacity - slabs[i].offset >= nbytes) {
+      s = i;
+      break;
+    }
+  }
+  if (s == slabs.size()) {
+    s = addSlab(nbytes);
+  }
+
+  _S &slab = slabs[s];
+  void *data = slab.data + slab.offset;
+  slab.offset += nbytes;
+  ++slab.live;
+  blocks[data] = {s, nbytes};
+  this->nbytes.used += nbytes;
+  return data;
+}
+
+void TimestepArena::release(void *data)
+{
+  if (data == nullptr) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  _B &block = blocks.at(data);
+  _S &slab = slabs[block.slab];
+  this->nbytes.used -= block.capacity;
+
+  if (--slab.live != 0) {
+    released.emplace(block.capacity, data);
+    return;
+  }
+
+  // Nothing in this slab is live anymore: forget its blocks and rewind it
+  size_t s = block.slab;
+  for (auto it = released.begin(); it != released.end(); ) {
+    if (blocks.at(it->second).slab == s) {
+      it = released.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  for (auto it = blocks.begin(); it != blocks.end(); ) {
+    if (it->second.slab == s) {
+      it = blocks.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  slab.offset = 0;
+}
+
+void TimestepArena::clear()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  for (const _S &slab : slabs) {
+    if (slab.live != 0) {
+      std::fprintf(stderr, "Arena: releasing slab with %zu live blocks\n", slab.live);
+    }
+    munmap(slab.data, slab.capacity);
+  }
+  slabs.clear();
+  blocks.clear();
+  released.clear();
+  nbytes.used = 0;
+  nbytes.reserved = 0;
+}
+
+}  // namespace mikr_plugin
+}  // namespace ospray
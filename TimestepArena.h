@@ -0,0 +1,70 @@
+// Copyright 2009-2021 Intel Corporation
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace ospray {
+namespace mikr_plugin {
+
+// Hands out 64-byte aligned timestep buffers carved from a few large
+// mmap'd slabs (optionally backed by transparent huge pages). Released
+// buffers are kept for reuse by later timesteps; a slab whose buffers have
+// all been released is rewound as a whole. Memory only goes back to the
+// system in clear().
+struct TimestepArena
+{
+  static constexpr size_t alignment = 64;
+
+  TimestepArena(size_t slabSize = 64ul << 20, bool useHugePages = true);
+  ~TimestepArena();
+
+  TimestepArena(const TimestepArena &) = delete;
+  TimestepArena &operator=(const TimestepArena &) = delete;
+
+  static size_t round(size_t nbytes);
+
+  void reserve(size_t nbytes);
+  void *allocate(size_t nbytes);
+  void release(void *data);
+  void clear();
+
+  size_t used() const { return nbytes.used; }
+  size_t reserved() const { return nbytes.reserved; }
+
+protected:
+  struct _S {
+    char *data; // slabs[i].data
+    size_t capacity; // slabs[i].capacity
+    size_t offset; // slabs[i].offset
+    size_t live; // slabs[i].live
+  };
+  std::vector<_S> slabs;
+
+  struct _B {
+    size_t slab; // blocks[data].slab
+    size_t capacity; // blocks[data].capacity
+  };
+  std::unordered_map<void *, _B> blocks; // live and released blocks by address
+  std::multimap<size_t, void *> released; // released blocks by capacity
+
+  struct {
+    std::atomic<size_t> used; // nbytes.used
+    std::atomic<size_t> reserved; // nbytes.reserved
+  } nbytes;
+
+  size_t slabSize;
+  bool useHugePages;
+  std::mutex mutex;
+
+  size_t addSlab(size_t nbytes);
+};
+
+}  // namespace mikr_plugin
+}  // namespace ospray
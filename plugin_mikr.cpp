@@ -24,17 +24,18 @@ struct PluginMikr : public Plugin
       int ac = studioCommon.argc;
       const char **av = studioCommon.argv;
 
-      std::string optDefaultFilename;
+      // Repeat the option to compare several datasets
+      std::vector<std::string> optDefaultFilenames;
 
       for (int i=1; i<ac; ++i) {
         std::string arg = av[i];
         if (arg == "--plugin:mikr:defaultFilename") {
-          optDefaultFilename = av[i + 1];
+          optDefaultFilenames.push_back(av[i + 1]);
           ++i;
         }
       }
 
-      panels.emplace_back(new PanelMikr(ctx, optDefaultFilename));
+      panels.emplace_back(new PanelMikr(ctx, optDefaultFilenames));
     }
     else
       std::cout << "Plugin functionality unavailable in Batch mode .."
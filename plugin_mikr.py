@@ -6,27 +6,30 @@
 """
 
 from __future__ import annotations
-from collections import namedtuple
-from contextlib import redirect_stderr
+from collections import OrderedDict, namedtuple
+from concurrent.futures import Future, ThreadPoolExecutor
+from contextlib import nullcontext, redirect_stderr
 import csv
-from dataclasses import dataclass
-from io import TextIOWrapper
+from hashlib import blake2b
+from dataclasses import dataclass, field
+from functools import cached_property
+from io import BufferedReader, BytesIO, RawIOBase, TextIOWrapper
 from itertools import permutations
 from math import copysign
+import mmap
 import os
 from pathlib import Path
+import signal
+import socket
+import socketserver
 import struct
 import sys
+import threading
 from typing import NewType
-from zipfile import ZipFile as zip_open
+from zipfile import ZIP_DEFLATED, ZIP_STORED, ZipFile as zip_open
+import zlib
 
 import numpy as np
-if sys.version_info >= (3, 10, 0):
-    from zipfile import Path as ZipPath
-else:
-    # Python before 3.10 has a bug with zipfile.Path, but Python library zipp
-    # has a fix. https://bugs.python.org/issue40564
-    from zipp import Path as ZipPath
 
 
 PointID = NewType('PointID', str)
@@ -40,21 +43,26 @@ VertexPositionArray = NewType('VertexPositionArray', np.ndarray)
 IndexArray = NewType('IndexArray', np.ndarray)
 CellIndexArray = NewType('CellIndexArray', np.ndarray)
 CellDataArray = NewType('CellDataArray', np.ndarray)
+Bounds = NewType('Bounds', tuple)
 
 
 @dataclass
 class Mikr:
-    root: Union[Path, ZipPath]
+    root: Union[Path, ZipMember]
     points: Dict[PointID, Point]
     boxes: Dict[BoxID, Box]
     timesteps: List[Timestep]
     timestep: Optional[Timestep]
     stresses: Optional[Dict[BoxID, Stress]]
+    prefetched: Dict[Timestep, Future] = field(default_factory=dict)
+    # The loader service keeps every timestep's cell data once parsed, so
+    # that reopening the dataset skips the CSV parse entirely.
+    cached: Optional[Dict[Timestep, CellDataArray]] = None
 
     @classmethod
     def parseall(
         cls,
-        root: Union[Path, ZipPath],
+        root: Union[Path, ZipMember],
     ) -> Mikr:
         print(f'{root=}')
         print(f'{root/"nodes.csv"=}')
@@ -86,15 +94,45 @@ class Mikr:
         timestep: Timestep,
     ):
         assert timestep in self.timesteps
-        with (self.root / 'S' / f'{timestep}.csv').open('r') as f:
+
+        if self.cached is not None and timestep in self.cached:
+            self.stresses = None
+            self.timestep = timestep
+            return
+
+        # Read (and for archives, inflate) this timestep and the next few in
+        # parallel, one member per thread, while this one is being parsed.
+        # Parsing is serial, so a short window already keeps it busy; every
+        # timestep in it is held in memory whole.
+        i = self.timesteps.index(timestep)
+        window = self.timesteps[i:i+1+PREFETCH]
+        for t in list(self.prefetched):
+            if t not in window:
+                self.prefetched.pop(t).cancel()
+        for t in window:
+            if t not in self.prefetched and (self.cached is None or t not in self.cached):
+                path = self.root / 'S' / f'{t}.csv'
+                self.prefetched[t] = executor().submit(path.read_bytes)
+
+        with open_text(self.prefetched.pop(timestep).result()) as f:
             stresses = Stress.parseall(f)
         self.stresses = stresses
         self.timestep = timestep
+
+    @property
+    def bounds(
+        self,
+    ) -> Bounds:
+        xs = [point.x for point in self.points.values()]
+        ys = [point.y for point in self.points.values()]
+        zs = [point.z for point in self.points.values()]
+        return (min(xs), min(ys), min(zs)), (max(xs), max(ys), max(zs))
     
-    def as_numpy(
+    @cached_property
+    def mesh(
         self,
-    ) -> Tuple[VertexPositionArray, IndexArray, CellIndexArray, CellDataArray]:
-        assert self.timestep is not None
+    ) -> Tuple[VertexPositionArray, IndexArray, Dict[BoxID, int]]:
+        # Independent of the timestep, so only built once per dataset
         NP = len(self.points)
         plookup: Dict[PointID, int] = {}
         vertex_position = np.ones((NP, 3), dtype='float32')
@@ -124,19 +162,34 @@ class Mikr:
             )
         assert -373737 not in index
 
+        return vertex_position, index, blookup
+
+    def as_numpy(
+        self,
+        roi: Optional[Bounds]=None,
+    ) -> Tuple[VertexPositionArray, IndexArray, CellIndexArray, CellDataArray]:
+        assert self.timestep is not None
+        vertex_position, index, blookup = self.mesh
+        NB = index.shape[0]
+
         cell_index = np.arange(0, NB, dtype='uint32').reshape((NB, 1))
         cell_index[:] *= 8
 
         cell_type = np.ones((NB, 1), dtype='uint8')
         cell_type[:] *= 12
 
-        cell_data = np.ones((NB, 1), dtype='float32')
-        cell_data[:] *= -373737
-        for bid, stress in self.stresses.items():
-            if (i := blookup.get(bid, None)) is None:
-                print(f'{bid=} not in blookup', file=sys.stderr)
-                continue
-            cell_data[i, :] = stress.s11
+        if self.cached is not None and self.timestep in self.cached:
+            cell_data = self.cached[self.timestep]
+        else:
+            cell_data = np.ones((NB, 1), dtype='float32')
+            cell_data[:] *= -373737
+            for bid, stress in self.stresses.items():
+                if (i := blookup.get(bid, None)) is None:
+                    print(f'{bid=} not in blookup', file=sys.stderr)
+                    continue
+                cell_data[i, :] = stress.s11
+            if self.cached is not None:
+                self.cached[self.timestep] = cell_data
         it = iter(zip(range(0, NB-1), range(1, NB)))
         for i, _ in it:
             if cell_data[i] == -373737:
@@ -150,6 +203,26 @@ class Mikr:
         cell_index = cell_index[:cutoff, :]
         cell_type = cell_type[:cutoff, :]
         cell_data = cell_data[:cutoff, :]
+
+        if roi is not None:
+            # Keep only the cells whose bounds intersect the region of
+            # interest, then drop the vertices no remaining cell refers to.
+            lo, hi = np.array(roi, dtype='float32')
+            corners = vertex_position[index]
+            keep = (
+                np.all(corners.max(axis=1) >= lo, axis=1) &
+                np.all(corners.min(axis=1) <= hi, axis=1)
+            )
+            print(f'Cropping {index.shape[0]-np.count_nonzero(keep)} elements outside {roi=}', file=sys.stderr)
+            index = index[keep, :]
+            cell_type = cell_type[keep, :]
+            cell_data = cell_data[keep, :]
+            NB = index.shape[0]
+            cell_index = np.arange(0, NB, dtype='uint32').reshape((NB, 1))
+            cell_index[:] *= 8
+            used, inverse = np.unique(index, return_inverse=True)
+            vertex_position = vertex_position[used, :]
+            index = inverse.reshape((NB, 8)).astype('int32')
             
         assert -373737 not in vertex_position, f'{np.where(vertex_position == -373737)}'
         assert -373737 not in index, f'{np.where(index == -373737)}'
@@ -351,63 +424,393 @@ class Stress:
         return stresses
 
 
+PREFETCH = 2  # timesteps read ahead of the one being parsed
+_executor: Optional[ThreadPoolExecutor] = None
+
+
+def executor() -> ThreadPoolExecutor:
+    global _executor
+    if _executor is None:
+        _executor = ThreadPoolExecutor(max_workers=1+PREFETCH)
+    return _executor
+
+
+class MemoryviewReader(RawIOBase):
+    """Raw stream over a memoryview, so that stored archive members can be
+    parsed straight out of the memory map without copying them first.
+    """
+
+    def __init__(
+        self,
+        view: memoryview,
+    ):
+        self.view = view
+        self.offset = 0
+
+    def readable(
+        self,
+    ) -> bool:
+        return True
+
+    def readinto(
+        self,
+        b,
+    ) -> int:
+        n = min(len(b), len(self.view) - self.offset)
+        b[:n] = self.view[self.offset:self.offset+n]
+        self.offset += n
+        return n
+
+
+def open_text(
+    data: Union[bytes, memoryview],
+) -> TextIO:
+    if isinstance(data, memoryview):
+        f = BufferedReader(MemoryviewReader(data))
+    else:
+        f = BytesIO(data)
+    return TextIOWrapper(f, encoding='utf-8', newline='')
+
+
+class ZipArchive:
+    """Memory-mapped .zip file.
+
+    Stored members are returned as views into the map and deflated members
+    are inflated with zlib, which releases the GIL, so several members can
+    be read in parallel from worker threads.
+    """
+
+    def __init__(
+        self,
+        path: Path,
+    ):
+        self.path = path
+        with open(path, 'rb') as f:
+            self.mmap = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        with zip_open(path, 'r') as z:
+            self.infos = {
+                info.filename.rstrip('/'): info
+                for info in z.infolist()
+            }
+        self.dirs = {''}
+        for name, info in self.infos.items():
+            parts = name.split('/')
+            for i in range(1, len(parts)):
+                self.dirs.add('/'.join(parts[:i]))
+            if info.is_dir():
+                self.dirs.add(name)
+
+    def __truediv__(
+        self,
+        part: str,
+    ) -> ZipMember:
+        return ZipMember(self, '') / part
+
+    def read_bytes(
+        self,
+        name: str,
+    ) -> Union[bytes, memoryview]:
+        info = self.infos[name]
+        if info.flag_bits & 0x1:
+            raise NotImplementedError(f'{name=} is encrypted')
+
+        # The local header's name and extra field lengths may differ from
+        # the central directory's, so they have to be read from the map.
+        signature, = struct.unpack_from('<I', self.mmap, info.header_offset)
+        assert signature == 0x04034b50, f'{name=} {signature=:#x}'
+        name_length, extra_length = struct.unpack_from('<HH', self.mmap, info.header_offset + 26)
+        begin = info.header_offset + 30 + name_length + extra_length
+        data = memoryview(self.mmap)[begin:begin+info.compress_size]
+
+        if info.compress_type == ZIP_STORED:
+            return data
+        elif info.compress_type == ZIP_DEFLATED:
+            return zlib.decompress(data, -zlib.MAX_WBITS, info.file_size)
+        else:
+            raise NotImplementedError(f'{name=} {info.compress_type=}')
+
+
+class ZipMember:
+    """The subset of pathlib.Path that Mikr and zip_aware_path use."""
+
+    def __init__(
+        self,
+        archive: ZipArchive,
+        at: str,
+    ):
+        self.archive = archive
+        self.at = at
+
+    def __repr__(
+        self,
+    ) -> str:
+        return f'ZipMember({str(self.archive.path)!r}, {self.at!r})'
+
+    def __truediv__(
+        self,
+        part: str,
+    ) -> ZipMember:
+        return ZipMember(self.archive, f'{self.at}/{part}' if self.at else part)
+
+    @property
+    def name(
+        self,
+    ) -> str:
+        return self.at.rsplit('/', 1)[-1]
+
+    @property
+    def suffix(
+        self,
+    ) -> str:
+        return Path(self.name).suffix
+
+    def is_dir(
+        self,
+    ) -> bool:
+        return self.at in self.archive.dirs
+
+    def is_file(
+        self,
+    ) -> bool:
+        return self.at in self.archive.infos and self.at not in self.archive.dirs
+
+    def iterdir(
+        self,
+    ) -> Iterator[ZipMember]:
+        prefix = f'{self.at}/' if self.at else ''
+        children = set()
+        for name in self.archive.infos:
+            if name.startswith(prefix) and name != self.at:
+                children.add(name[len(prefix):].split('/', 1)[0])
+        for child in sorted(children):
+            yield self / child
+
+    def read_bytes(
+        self,
+    ) -> Union[bytes, memoryview]:
+        return self.archive.read_bytes(self.at)
+
+    def open(
+        self,
+        mode: str='r',
+    ) -> TextIO:
+        assert mode == 'r', f'{mode=}'
+        return open_text(self.read_bytes())
+
+
+def session(stdin, stdout, open_dataset):
+    def write(fmt, *args):
+        print(f'write({fmt=})', file=sys.stderr)
+        stdout.write(struct.pack(fmt, *args))
+    def read(fmt):
+        print(f'read({fmt=})', file=sys.stderr)
+        size = struct.calcsize(fmt)
+        data = stdin.read(size)
+        if len(data) != size:
+            # Studio closed the pipe without sending a negative index
+            raise EOFError(f'{fmt=} {size=} {len(data)=}')
+        return struct.unpack(fmt, data)
+
+    # Start
+    n, = read('@n')
+    if n < 0:
+        return
+    
+    # Load
+    mikr, lock = open_dataset()
+    write('@n', len(mikr.timesteps))
+    for timestep in mikr.timesteps:
+        timestep = timestep.encode('utf-8')
+        write('@n', len(timestep))
+        write(f'{len(timestep)}s', timestep)
+    lo, hi = mikr.bounds
+    write('@3f', *lo)
+    write('@3f', *hi)
+    stdout.flush()
+
+    while True:
+        # Transfer
+        timestep_index, = read('@n')
+        if timestep_index < 0:
+            break
+        roi_enabled, = read('@n')
+        roi = read('@3f'), read('@3f')
+        with lock:
+            mikr.load(mikr.timesteps[timestep_index])
+            vertex_position, index, cell_index, cell_type, cell_data = mikr.as_numpy(
+                roi=roi if roi_enabled else None,
+            )
+        NP = vertex_position.shape[0]
+        NB = index.shape[0]
+        write('@n', NP)
+        write('@n', NB)
+
+        # Studio keeps one copy of each distinct mesh and only asks for
+        # the mesh arrays when it has not seen their digest before.
+        topology = (vertex_position, index, cell_index, cell_type)
+        digest = blake2b(digest_size=16)
+        for arr in topology:
+            digest.update(arr.tobytes())
+        write('16s', digest.digest())
+        stdout.flush()
+        need_topology, = read('@n')
+
+        for arr in (topology if need_topology else ()) + (cell_data,):
+            print(f'{arr.dtype=}', file=sys.stderr)
+            write('@n', arr.nbytes)
+            write(f'{arr.nbytes}s', arr.tobytes())
+        stdout.flush()
+
+
 def main(root):
     with os.fdopen(sys.stdout.fileno(), 'wb', closefd=False) as stdout, \
          os.fdopen(sys.stdin.fileno(), 'rb', closefd=False) as stdin:
         print(f'Hello from {__file__}', file=sys.stderr)
 
-        def write(fmt, *args):
-            print(f'write({fmt=})', file=sys.stderr)
-            stdout.write(struct.pack(fmt, *args))
-        def read(fmt):
-            print(f'read({fmt=})', file=sys.stderr)
-            return struct.unpack(fmt, stdin.read(struct.calcsize(fmt)))
+        session(stdin, stdout, lambda: (Mikr.parseall(root), nullcontext()))
 
-        # Start
-        n, = read('@n')
-        if n < 0:
-            return
-        
-        # Load
-        mikr = Mikr.parseall(root)
-        write('@n', len(mikr.timesteps))
-        for timestep in mikr.timesteps:
-            timestep = timestep.encode('utf-8')
-            write('@n', len(timestep))
-            write(f'{len(timestep)}s', timestep)
-        stdout.flush()
 
-        while True:
-            # Transfer
-            timestep_index, = read('@n')
-            if timestep_index < 0:
-                break
-            mikr.load(mikr.timesteps[timestep_index])
-            vertex_position, index, cell_index, cell_type, cell_data = mikr.as_numpy()
-            NP = vertex_position.shape[0]
-            NB = index.shape[0]
-            write('@n', NP)
-            write('@n', NB)
-            for arr in (vertex_position, index, cell_index, cell_type, cell_data):
-                print(f'{arr.dtype=}', file=sys.stderr)
-                write('@n', arr.nbytes)
-                write(f'{arr.nbytes}s', arr.tobytes())
-            stdout.flush()
+class DatasetCache:
+    """The most recently opened datasets, parsed once and shared by every
+    connection to the loader service."""
+
+    @dataclass
+    class Entry:
+        lock: threading.Lock = field(default_factory=threading.Lock)
+        mikr: Optional[Mikr] = None
+        stamp: Optional[tuple] = None
+
+    def __init__(
+        self,
+        capacity: int,
+    ):
+        self.capacity = capacity
+        self.lock = threading.Lock()
+        self.entries: OrderedDict[str, DatasetCache.Entry] = OrderedDict()
+
+    def get(
+        self,
+        path: str,
+    ) -> DatasetCache.Entry:
+        stamp = dataset_stamp(path)
+        with self.lock:
+            entry = self.entries.setdefault(path, DatasetCache.Entry())
+            self.entries.move_to_end(path)
+            while len(self.entries) > self.capacity:
+                evicted, _ = self.entries.popitem(last=False)
+                print(f'Evicting {evicted=}', file=sys.stderr)
+
+        with entry.lock:
+            if entry.mikr is None or entry.stamp != stamp:
+                # Sessions still on the previous parse keep their own copy
+                root = zip_aware_path(path)
+                print(f'Parsing {root=}', file=sys.stderr)
+                entry.mikr = Mikr.parseall(root)
+                entry.mikr.cached = {}
+                entry.stamp = stamp
+            else:
+                print(f'Reusing {path=}', file=sys.stderr)
+        return entry
+
+
+def dataset_stamp(
+    path: str,
+) -> tuple:
+    """Modification times and sizes of what a dataset is read from: the
+    archive it lives in, or each of its files."""
+    path = Path(path)
+    for parent in (path, *path.parents):
+        if parent.is_file():
+            stat = parent.stat()
+            return ((parent.name, stat.st_mtime_ns, stat.st_size),)
+
+    stamp = []
+    for f in (path / 'nodes.csv', path / 'elements.csv', *sorted((path / 'S').iterdir())):
+        stat = f.stat()
+        stamp.append((f.name, stat.st_mtime_ns, stat.st_size))
+    return tuple(stamp)
+
+
+def serve(address, cache):
+    datasets = DatasetCache(cache)
+
+    class Handler(socketserver.StreamRequestHandler):
+        wbufsize = -1
+
+        def handle(self):
+            try:
+                # Handshake: the absolute path of the dataset to open, since
+                # this service's working directory is not Studio's
+                data = self.rfile.read(struct.calcsize('@n'))
+                if len(data) != struct.calcsize('@n'):
+                    raise EOFError('handshake')
+                size, = struct.unpack('@n', data)
+                path = self.rfile.read(size).decode('utf-8')
+                print(f'Connection for {path=}', file=sys.stderr)
+                if not os.path.isabs(path):
+                    print(f'Not an absolute path, closing', file=sys.stderr)
+                    return
+
+                def open_dataset():
+                    entry = datasets.get(path)
+                    return entry.mikr, entry.lock
+
+                session(self.rfile, self.wfile, open_dataset)
+            except (EOFError, OSError) as e:
+                print(f'Studio went away: {e!r}', file=sys.stderr)
+
+    class Server(socketserver.ThreadingUnixStreamServer):
+        daemon_threads = True
+
+    # A socket file left behind by a service that died is stale; one that
+    # still accepts connections means the service is already running.
+    if os.path.exists(address):
+        with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as probe:
+            try:
+                probe.connect(address)
+            except OSError:
+                os.unlink(address)
+            else:
+                print(f'Already serving on {address=}', file=sys.stderr)
+                return
+
+    umask = os.umask(0o077)
+    try:
+        server = Server(address, Handler)
+    finally:
+        os.umask(umask)
+
+    # Turn a plain kill into an orderly exit so the socket file is removed
+    signal.signal(signal.SIGTERM, lambda *_: sys.exit(0))
+
+    print(f'Serving on {address=}', file=sys.stderr)
+    with server:
+        try:
+            server.serve_forever()
+        finally:
+            os.unlink(address)
+
+
+def zip_aware_path(s):
+    path = Path(s)
+    parts = path.parts
+    root = Path(parts[0])
+    for part in parts[1:]:
+        path = root / part
+        if path.is_dir():
+            root = path
+            continue
+        assert path.is_file() and path.suffix == '.zip'
+        root = ZipArchive(path) / ''
+    return root
+
+
+def default_root():
+    return zip_aware_path(Path.cwd() / 'data' / 'bridge_15mm' / 'bridge_15mm_subset.zip' / 'bridge_15mm')
 
 
 def cli():
-    def zip_aware_path(s):
-        path = Path(s)
-        parts = path.parts
-        root = Path(parts[0])
-        for part in parts[1:]:
-            path = root / part
-            if path.is_dir():
-                root = path
-                continue
-            assert path.is_file() and path.suffix == '.zip'
-            root = ZipPath(zip_open(path, 'r'))
-        return root
+    global PREFETCH
 
     import argparse
 
@@ -418,12 +821,39 @@ def cli():
         default=None,
         dest='root',
     )
+    parser.add_argument(
+        '--serve',
+        default=None,
+        dest='address',
+        help='Keep running as a loader service on this Unix socket',
+    )
+    parser.add_argument(
+        '--cache',
+        type=int,
+        default=4,
+        help='Number of parsed datasets the loader service keeps',
+    )
+    parser.add_argument(
+        '--prefetch',
+        type=int,
+        default=PREFETCH,
+        help='Number of timesteps to read ahead of the one being parsed',
+    )
     args = vars(parser.parse_args())
 
+    PREFETCH = max(0, args.pop('prefetch'))
+
+    if args['address'] is not None:
+        serve(args['address'], args['cache'])
+        return
+
     if args['root'] is None:
-        args['root'] = zip_aware_path(Path.cwd() / 'data' / 'bridge_15mm' / 'bridge_15mm_subset.zip' / 'bridge_15mm')
+        args['root'] = default_root()
 
-    main(**args)
+    try:
+        main(args['root'])
+    except (EOFError, BrokenPipeError) as e:
+        print(f'Studio went away: {e!r}', file=sys.stderr)
 
 
 if __name__ == '__main__':